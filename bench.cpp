@@ -0,0 +1,716 @@
+//benchmark harness for the word counting building blocks, built and run by
+//"make bench". Every benchmark prints one tab separated line, so the output
+//of two builds can be lined up with diff, join or a spreadsheet:
+//  benchmark corpus ops ns_per_op tokens_per_s allocations rss_growth_kb
+//ns_per_op is the fastest of the repeated runs, tokens_per_s is given for
+//benchmarks that go through every token of the corpus and is "-" otherwise,
+//allocations counts calls to operator new during one run, and rss_growth_kb
+//is how far the resident set size of the process rose above where it was 
+//when the benchmark started, at its highest during the repeated runs. The 
+//peak is reset before each benchmark through /proc/self/clear_refs, so it 
+//belongs to that benchmark alone; where that is not available the column 
+//is "-". Memory that earlier benchmarks freed but the allocator kept is 
+//reused without growing the resident set, so the column is a lower bound 
+//on what a benchmark needs and 0 for most small ones. The ops of the classify_ benchmarks are bytes, so 1 / ns_per_op 
+//is their speed in GB/s on one core.
+//usage: Bench.out [repeats] [filter], filter keeps benchmarks whose name
+//contains it. Without a filter only the bundled input files are run, which
+//takes seconds; with one, "_" for every benchmark, the generated zipf, 
+//uniform and sorted corpora are run as well, and so are the strategy_ runs
+//on the zipf5m corpus and the depth_ runs, which take minutes
+#include <unistd.h>         // for close, unlink
+
+#include <algorithm>        // for min, sort, upper_bound
+#include <chrono>           // for steady_clock
+#include <cstdio>           // for printf, snprintf
+#include <cstdlib>          // for malloc, free, atoi, mkstemp
+#include <fstream>          // for ofstream
+#include <functional>       // for function
+#include <iostream>         // for cerr
+#include <new>              // for bad_alloc
+#include <random>           // for mt19937
+#include <sstream>          // for stringstream
+#include <string>           // for string
+#include <string_view>      // for string_view
+#include <unordered_set>    // for unordered_set
+#include <utility>          // for pair
+#include <vector>           // for vector
+
+#include "flat_count_map.h"
+#include "hashed_splays.h"
+#include "indexed_splay_tree.h"
+#include "node.h"
+#include "scan_kernel.h"
+#include "sorted_block_map.h"
+#include "splay_tree.h"
+#include "string_pool.h"
+#include "tokenizer.h"
+#include "top_down_splay_tree.h"
+#include "word_sink.h"
+
+//every allocation made by the process goes through here, so each benchmark
+//can report how many it made
+static long allocation_count = 0;
+
+void* operator new(std::size_t size) {
+  ++allocation_count;
+  if (void* memory = std::malloc(size ? size : 1))
+    return memory;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {std::free(memory);}
+
+void operator delete(void* memory, std::size_t) noexcept {std::free(memory);}
+
+namespace {
+
+const int GENERATED_TOKENS = 500000;     // words in each generated corpus
+const int GENERATED_VOCABULARY = 50000;  // distinct words they are drawn from
+const int WORDS_PER_LINE = 12;
+const int SORTED_WORDS = 10000000;       // distinct words of the depth_ runs
+const int SORTED_LOOKUPS = 1000000;      // random searches in those runs
+const int LARGE_ZIPF_TOKENS = 5000000;   // words of the strategy_ corpus
+const int LARGE_ZIPF_VOCABULARY = 500000;
+const int INFIX_QUERIES = 200;           // substring queries of contains_ runs
+
+//results that are only computed to be thrown away are stored here, so the
+//compiler cannot drop the work
+volatile long sink = 0;
+
+//text to be counted, along with its words as the tokenizer sees them
+struct Corpus {
+  std::string name;
+  std::string file_name;               // where the text can be read from
+  std::string text;
+  std::vector<std::string> tokens;
+  std::vector<std::string> distinct;   // in order of first appearance
+};
+
+//makes count random words of 1 to 12 letters, a few of them capitalized
+std::vector<std::string> makeVocabulary(int count, std::mt19937& random) {
+  std::unordered_set<std::string> seen;
+  std::vector<std::string> vocabulary;
+  std::uniform_int_distribution<int> length(1, 12);
+  std::uniform_int_distribution<int> letter(0, 25);
+  while (static_cast<int>(vocabulary.size()) < count) {
+    std::string word(length(random), 'a');
+    for (char& c : word)
+      c = static_cast<char>('a' + letter(random));
+    if (letter(random) < 3)
+      word[0] = static_cast<char>(word[0] - 'a' + 'A');
+    if (seen.insert(word).second)
+      vocabulary.push_back(word);
+  }
+  return vocabulary;
+}
+
+//draws count words from vocabulary by a Zipf distribution, where rank r is
+//drawn with probability proportional to 1 / r
+std::vector<std::string> drawZipf(const std::vector<std::string>& vocabulary,
+				  int count, std::mt19937& random) {
+  std::vector<double> cumulative(vocabulary.size());
+  double total {0};
+  for (std::size_t r = 0; r < vocabulary.size(); ++r)
+    cumulative[r] = total += 1.0 / (r + 1);
+  std::uniform_real_distribution<double> uniform_real(0, total);
+  std::vector<std::string> words(count);
+  for (std::string& word : words) {
+    std::size_t rank = std::upper_bound(cumulative.begin(), cumulative.end(),
+					uniform_real(random)) - cumulative.begin();
+    word = vocabulary[std::min(rank, vocabulary.size() - 1)];
+  }
+  return words;
+}
+
+//joins words into lines of text, and writes the text to a temporary file
+Corpus makeCorpus(std::string name, const std::vector<std::string>& words) {
+  Corpus corpus;
+  corpus.name = name;
+  for (std::size_t i = 0; i < words.size(); ++i) {
+    corpus.text += words[i];
+    corpus.text += (i + 1) % WORDS_PER_LINE ? ' ' : '\n';
+  }
+  char file_name[] = "/tmp/wfc_bench_XXXXXX";
+  int file_descriptor = mkstemp(file_name);
+  if (file_descriptor >= 0) {
+    close(file_descriptor);
+    std::ofstream out_file{file_name, std::ios::binary};
+    out_file << corpus.text;
+    corpus.file_name = file_name;
+  }
+  return corpus;
+}
+
+Corpus readCorpus(std::string file_name) {
+  Corpus corpus;
+  corpus.name = file_name;
+  corpus.file_name = file_name;
+  std::ifstream in_file{file_name, std::ios::binary};
+  std::stringstream contents;
+  contents << in_file.rdbuf();
+  corpus.text = contents.str();
+  return corpus;
+}
+
+//fills in the tokens of a corpus from its text
+void tokenize(Corpus& corpus) {
+  std::unordered_set<std::string> seen;
+  Tokenizer tokenizer(corpus.text.data(),
+		      corpus.text.data() + corpus.text.size());
+  std::string_view word;
+  while (tokenizer.next(word)) {
+    corpus.tokens.emplace_back(word);
+    if (seen.emplace(word).second)
+      corpus.distinct.emplace_back(word);
+  }
+}
+
+//input1.txt and input2.txt, plus words drawn from a random vocabulary by a
+//Zipf distribution, uniformly, and in sorted order, which makes every
+//insertion go to the far end of the tree
+std::vector<Corpus> makeCorpora(bool generated) {
+  std::vector<Corpus> corpora;
+  corpora.push_back(readCorpus("input1.txt"));
+  corpora.push_back(readCorpus("input2.txt"));
+  if (!generated) {
+    for (Corpus& corpus : corpora)
+      tokenize(corpus);
+    return corpora;
+  }
+
+  std::mt19937 random(12345);
+  std::vector<std::string> vocabulary {
+    makeVocabulary(GENERATED_VOCABULARY, random)};
+  std::vector<std::string> words {
+    drawZipf(vocabulary, GENERATED_TOKENS, random)};
+  corpora.push_back(makeCorpus("zipf", words));
+
+  std::uniform_int_distribution<std::size_t> uniform(0, vocabulary.size() - 1);
+  for (std::string& word : words)
+    word = vocabulary[uniform(random)];
+  corpora.push_back(makeCorpus("uniform", words));
+
+  std::sort(words.begin(), words.end());
+  corpora.push_back(makeCorpus("sorted", words));
+
+  for (Corpus& corpus : corpora)
+    tokenize(corpus);
+  return corpora;
+}
+
+//the value in kB of field, such as "VmRSS:", in /proc/self/status, or -1 if
+//it cannot be read
+long statusKb(const std::string& field) {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line))
+    if (line.compare(0, field.size(), field) == 0)
+      return std::atol(line.c_str() + field.size());
+  return -1;
+}
+
+//sets the peak resident set size (VmHWM) back to the current one, returns
+//false if the kernel does not allow it
+bool resetPeakRss() {
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  clear_refs << "5";
+  clear_refs.close();
+  return static_cast<bool>(clear_refs);
+}
+
+//runs body repeats times and prints the line for the fastest run; body does
+//one run and returns the number of operations it performed, which are the 
+//tokens of the corpus if per_token is set
+void report(const std::string& benchmark, const Corpus& corpus, int repeats,
+	    bool per_token, const std::function<long()>& body) {
+  double best_ns {0};
+  long ops {0};
+  long allocations {0};
+  bool peak_reset {resetPeakRss()};
+  long rss_before {statusKb("VmRSS:")};
+  for (int i = 0; i < repeats; ++i) {
+    long allocations_before {allocation_count};
+    auto start = std::chrono::steady_clock::now();
+    ops = body();
+    auto stop = std::chrono::steady_clock::now();
+    allocations = allocation_count - allocations_before;
+    double ns {std::chrono::duration<double, std::nano>(stop - start).count()};
+    if (i == 0 || ns < best_ns)
+      best_ns = ns;
+  }
+  std::string tokens_per_s {"-"};
+  if (per_token && best_ns > 0)
+    tokens_per_s = std::to_string(static_cast<long>(ops * 1e9 / best_ns));
+  long rss_peak {statusKb("VmHWM:")};
+  std::string rss_growth {"-"};
+  if (peak_reset && rss_before >= 0 && rss_peak >= 0)
+    rss_growth = std::to_string(std::max(0L, rss_peak - rss_before));
+  std::printf("%s\t%s\t%ld\t%.1f\t%s\t%ld\t%s\n", benchmark.c_str(),
+	      corpus.name.c_str(), ops, ops ? best_ns / ops : 0.0,
+	      tokens_per_s.c_str(), allocations, rss_growth.c_str());
+  std::fflush(stdout);
+}
+
+//counts every token of the corpus into a single tree
+//counts every token of the corpus into tree, copying the words it inserts
+//into words like HashedSplays does
+template <typename Tree>
+void countInto(Tree& tree, const Corpus& corpus, StringPool& words) {
+  for (const std::string& token : corpus.tokens)
+    tree.upsert(PendingWord{token, &words});
+}
+
+//runs the tree benchmarks whose name contains filter on a Tree, with each
+//benchmark named after tree_name
+template <typename Tree>
+void benchmarkTree(const std::string& tree_name, const Corpus& corpus,
+		   int repeats, const std::string& filter) {
+  auto wanted = [&filter](const std::string& benchmark) {
+    return benchmark.find(filter) != std::string::npos;
+  };
+
+  //each distinct word once, in order of first appearance
+  if (wanted(tree_name + "_insert"))
+    report(tree_name + "_insert", corpus, repeats, false, [&corpus]() {
+	StringPool words;
+	Tree tree;
+	for (const std::string& word : corpus.distinct)
+	  tree.insert(Node(words, word, 1));
+	return static_cast<long>(corpus.distinct.size());
+      });
+
+  if (wanted(tree_name + "_upsert"))
+    report(tree_name + "_upsert", corpus, repeats, true, [&corpus]() {
+	StringPool words;
+	Tree tree;
+	countInto(tree, corpus, words);
+	return static_cast<long>(corpus.tokens.size());
+      });
+
+  //splays each token to the root of the fully counted tree in turn, with
+  //the nodes to splay made before the clock starts
+  StringPool words;
+  Tree counted;
+  countInto(counted, corpus, words);
+  if (wanted(tree_name + "_splay")) {
+    std::vector<Node> tokens;
+    tokens.reserve(corpus.tokens.size());
+    for (const std::string& token : corpus.tokens)
+      tokens.emplace_back(words, token, 0);
+    report(tree_name + "_splay", corpus, repeats, true, [&tokens, &counted]() {
+	for (const Node& token : tokens)
+	  counted.splay(token);
+	return static_cast<long>(tokens.size());
+      });
+  }
+
+  //one query for every two letter lower case prefix
+  if (wanted(tree_name + "_findAll"))
+    report(tree_name + "_findAll", corpus, repeats, false, [&counted]() {
+	long matches {0};
+	std::string prefix(2, 'a');
+	for (char first = 'a'; first <= 'z'; ++first)
+	  for (char second = 'a'; second <= 'z'; ++second) {
+	    prefix[0] = first;
+	    prefix[1] = second;
+	    counted.findAll(std::string_view(prefix),
+			    [&matches](const Node&) {++matches;});
+	  }
+	sink = matches;
+	return 26L * 26L;
+      });
+}
+
+//counts every token of the corpus into a splay tree with each splay 
+//strategy, and reports the splay steps and rotations of one run to cerr, 
+//the rotations only when built with WFC_STATS defined
+void benchmarkStrategies(const Corpus& corpus, int repeats,
+			 const std::string& filter) {
+  using Strategy = SplayTree<Node>::SplayStrategy;
+  const struct {
+    const char* name;
+    Strategy strategy;
+    double parameter;
+  } strategies[] {
+    {"strategy_always", Strategy::kAlways, 0},
+    {"strategy_every_4", Strategy::kEveryKth, 4},
+    {"strategy_every_16", Strategy::kEveryKth, 16},
+    {"strategy_deeper_8", Strategy::kDeeperThan, 8},
+    {"strategy_deeper_16", Strategy::kDeeperThan, 16},
+    {"strategy_random_0.25", Strategy::kRandom, 0.25},
+    {"strategy_random_0.05", Strategy::kRandom, 0.05}};
+
+  for (const auto& strategy : strategies) {
+    if (std::string(strategy.name).find(filter) == std::string::npos)
+      continue;
+    long splays {0};
+    TreeStats stats;
+    report(strategy.name, corpus, repeats, true, [&]() {
+	StringPool words;
+	SplayTree<Node> tree;
+	tree.setSplayStrategy(strategy.strategy, strategy.parameter);
+	countInto(tree, corpus, words);
+	splays = tree.getSplayCount();
+	stats = tree.getStats();
+	return static_cast<long>(corpus.tokens.size());
+      });
+    std::cerr << strategy.name << " on " << corpus.name << ": " << splays
+	      << " splay steps, " << stats.getRotationCount()
+	      << " rotations, average depth "
+	      << (stats.access_count ?
+		  static_cast<double>(stats.depth_sum) / stats.access_count : 0)
+	      << "\n";
+  }
+}
+
+//runs the table benchmarks whose name contains filter on a Table, the 
+//HashedSplays of one bucket container, with each benchmark named after 
+//table_name: counting the corpus with letter and hashed buckets and with
+//the infix index on, looking up every token, one prefix query and one top
+//10 completion for every two letter prefix, substring queries with and
+//without the infix index, and writing out every word, with the output of
+//the prefix queries and the dump going to /dev/null
+template <typename Table>
+void benchmarkTable(const std::string& table_name, const Corpus& corpus,
+		    int repeats, const std::string& filter) {
+  auto wanted = [&filter](const std::string& benchmark) {
+    return benchmark.find(filter) != std::string::npos;
+  };
+
+  if (wanted(table_name + "_count"))
+    report(table_name + "_count", corpus, repeats, true, [&corpus]() {
+	Table table(26);
+	table.processWordsFromFile(corpus.file_name);
+	return static_cast<long>(corpus.tokens.size());
+      });
+
+  if (wanted(table_name + "_count_hashed"))
+    report(table_name + "_count_hashed", corpus, repeats, true, [&corpus]() {
+	Table table(26, Table::Bucketing::kHashed);
+	table.processWordsFromFile(corpus.file_name);
+	return static_cast<long>(corpus.tokens.size());
+      });
+
+  if (wanted(table_name + "_count_indexed"))
+    report(table_name + "_count_indexed", corpus, repeats, true, [&corpus]() {
+	Table table(26);
+	table.setInfixIndexing(true);
+	table.processWordsFromFile(corpus.file_name);
+	return static_cast<long>(corpus.tokens.size());
+      });
+
+  if (!wanted(table_name + "_lookup") && !wanted(table_name + "_prefix") &&
+      !wanted(table_name + "_complete") && !wanted(table_name + "_dump") &&
+      !wanted(table_name + "_contains"))
+    return;
+  Table counted(26);
+  counted.processWordsFromFile(corpus.file_name);
+
+  if (wanted(table_name + "_lookup"))
+    report(table_name + "_lookup", corpus, repeats, true,
+	   [&corpus, &counted]() {
+	     long total {0};
+	     for (const std::string& token : corpus.tokens)
+	       total += counted.getFrequency(token);
+	     sink = total;
+	     return static_cast<long>(corpus.tokens.size());
+	   });
+
+  if (wanted(table_name + "_prefix"))
+    report(table_name + "_prefix", corpus, repeats, false, [&counted]() {
+	WordSink sink(WordSink::Format::kTsv);
+	sink.open("/dev/null");
+	std::string prefix(2, 'a');
+	for (char first = 'a'; first <= 'z'; ++first)
+	  for (char second = 'a'; second <= 'z'; ++second) {
+	    prefix[0] = first;
+	    prefix[1] = second;
+	    counted.writeMatches(prefix, sink);
+	  }
+	return 26L * 26L;
+      });
+
+  if (wanted(table_name + "_complete"))
+    report(table_name + "_complete", corpus, repeats, false, [&counted]() {
+	long total {0};
+	std::string prefix(2, 'a');
+	for (char first = 'a'; first <= 'z'; ++first)
+	  for (char second = 'a'; second <= 'z'; ++second) {
+	    prefix[0] = first;
+	    prefix[1] = second;
+	    total += counted.complete(prefix, 10).size();
+	  }
+	sink = total;
+	return 26L * 26L;
+      });
+
+  //three letters from inside words spread over the vocabulary, so that
+  //every query has at least one match
+  std::vector<std::string> infixes;
+  std::size_t step {std::max<std::size_t>(1, corpus.distinct.size() /
+					   INFIX_QUERIES)};
+  for (std::size_t i = 0; i < corpus.distinct.size(); i += step)
+    if (corpus.distinct[i].size() >= 5)
+      infixes.push_back(corpus.distinct[i].substr(1, 3));
+  auto contains = [&infixes, &counted]() {
+    long total {0};
+    for (const std::string& infix : infixes)
+      total += counted.findContaining(infix).size();
+    sink = total;
+    return static_cast<long>(infixes.size());
+  };
+
+  if (wanted(table_name + "_contains_scan"))
+    report(table_name + "_contains_scan", corpus, repeats, false, contains);
+
+  if (wanted(table_name + "_contains_indexed")) {
+    counted.setInfixIndexing(true);
+    report(table_name + "_contains_indexed", corpus, repeats, false, contains);
+    counted.setInfixIndexing(false);
+  }
+
+  if (wanted(table_name + "_dump"))
+    report(table_name + "_dump", corpus, repeats, false, [&corpus, &counted]() {
+	WordSink sink(WordSink::Format::kTsv);
+	sink.open("/dev/null");
+	counted.writeWords(sink);
+	return static_cast<long>(corpus.distinct.size());
+      });
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  int repeats {argc > 1 ? std::max(1, std::atoi(argv[1])) : 3};
+  std::string filter {argc > 2 ? argv[2] : ""};
+  std::vector<Corpus> corpora {makeCorpora(!filter.empty())};
+  auto wanted = [&filter](const std::string& benchmark) {
+    return benchmark.find(filter) != std::string::npos;
+  };
+  //the large corpora are only built when asked for with a filter
+  auto wanted_large = [&filter, &wanted](const std::string& benchmark) {
+    return !filter.empty() && wanted(benchmark);
+  };
+
+  std::printf("benchmark\tcorpus\tops\tns_per_op\ttokens_per_s\t"
+	      "allocations\trss_growth_kb\n");
+  for (const Corpus& corpus : corpora) {
+    if (corpus.text.empty()) {
+      std::cerr << "Error in opening file " << corpus.name << "!\n";
+      continue;
+    }
+
+    if (wanted("tokenizer"))
+      report("tokenizer", corpus, repeats, true, [&corpus]() {
+	  Tokenizer tokenizer(corpus.text.data(),
+			      corpus.text.data() + corpus.text.size());
+	  std::string_view word;
+	  long count {0};
+	  while (tokenizer.next(word))
+	    ++count;
+	  sink = count;
+	  return count;
+	});
+
+    //the tokenizer and its byte classification kernel at every level the
+    //processor supports, and with case folding on the best one
+    for (ScanKernel::Level level : {ScanKernel::kScalar, ScanKernel::kSse2,
+				    ScanKernel::kAvx2}) {
+      if (!ScanKernel::isSupported(level))
+	continue;
+      ScanKernel kernel(level);
+      std::string suffix {std::string("_") + kernel.getName()};
+      if (wanted("tokenizer" + suffix))
+	report("tokenizer" + suffix, corpus, repeats, true, [&corpus, &kernel]() {
+	    Tokenizer tokenizer;
+	    tokenizer.setKernel(kernel);
+	    tokenizer.reset(corpus.text.data(),
+			    corpus.text.data() + corpus.text.size());
+	    std::string_view word;
+	    long count {0};
+	    while (tokenizer.next(word))
+	      ++count;
+	    sink = count;
+	    return count;
+	  });
+      if (wanted("classify" + suffix))
+	report("classify" + suffix, corpus, repeats, false, [&corpus, &kernel]() {
+	    std::size_t blocks {corpus.text.size() / ScanKernel::kBlockSize};
+	    std::uint64_t word_mask, space_mask;
+	    long words {0};
+	    for (std::size_t i = 0; i < blocks; ++i) {
+	      kernel.classifyBlock(corpus.text.data() +
+				   i * ScanKernel::kBlockSize,
+				   word_mask, space_mask);
+	      words += __builtin_popcountll(word_mask & ~space_mask);
+	    }
+	    sink = words;
+	    return static_cast<long>(blocks * ScanKernel::kBlockSize);
+	  });
+    }
+
+    if (wanted("tokenizer_fold"))
+      report("tokenizer_fold", corpus, repeats, true, [&corpus]() {
+	  Tokenizer tokenizer(corpus.text.data(),
+			      corpus.text.data() + corpus.text.size());
+	  tokenizer.setFoldCase(true);
+	  std::string_view word;
+	  long count {0};
+	  while (tokenizer.next(word))
+	    ++count;
+	  sink = count;
+	  return count;
+	});
+
+    //the same operations on every tree variant
+    benchmarkTree<SplayTree<Node>>("splay", corpus, repeats, filter);
+    benchmarkTree<IndexedSplayTree<Node>>("indexed", corpus, repeats, filter);
+    benchmarkTree<TopDownSplayTree<Node>>("topdown", corpus, repeats, filter);
+
+    benchmarkStrategies(corpus, repeats, filter);
+
+    //the same operations on HashedSplays with every bucket container
+    benchmarkTable<HashedSplays>("table_splay", corpus, repeats, filter);
+    benchmarkTable<BasicHashedSplays<FlatCountMap<Node>>>(
+	"table_flat", corpus, repeats, filter);
+    benchmarkTable<BasicHashedSplays<SortedBlockMap<Node>>>(
+	"table_blocks", corpus, repeats, filter);
+
+    if (wanted("hashed_process"))
+      report("hashed_process", corpus, repeats, true, [&corpus]() {
+	  HashedSplays table(26);
+	  table.processWordsFromFile(corpus.file_name);
+	  return static_cast<long>(corpus.tokens.size());
+	});
+
+    if (wanted("hashed_process_hashed"))
+      report("hashed_process_hashed", corpus, repeats, true, [&corpus]() {
+	  HashedSplays table(26, HashedSplays::Bucketing::kHashed);
+	  table.processWordsFromFile(corpus.file_name);
+	  return static_cast<long>(corpus.tokens.size());
+	});
+
+    //dumps the distinct words of a counted table to a temporary file, with 
+    //a stream insertion per word as printTree does, and through a WordSink 
+    //in each of its formats
+    if (wanted("dump_")) {
+      HashedSplays table(26);
+      table.processWordsFromFile(corpus.file_name);
+      char dump_name[] = "/tmp/wfc_dump_XXXXXX";
+      int dump_descriptor {mkstemp(dump_name)};
+      close(dump_descriptor);
+      long words {static_cast<long>(corpus.distinct.size())};
+      if (wanted("dump_ostream"))
+	report("dump_ostream", corpus, repeats, false, [&]() {
+	    std::ofstream out_file(dump_name);
+	    std::streambuf* old_buffer {std::cout.rdbuf(out_file.rdbuf())};
+	    for (int i = 0; i < table.getTreeCount(); ++i)
+	      table.printTree(i);
+	    std::cout.rdbuf(old_buffer);
+	    return words;
+	  });
+      const std::pair<const char*, WordSink::Format> formats[] {
+	{"dump_tsv", WordSink::Format::kTsv},
+	{"dump_csv", WordSink::Format::kCsv},
+	{"dump_jsonl", WordSink::Format::kJsonLines},
+	{"dump_binary", WordSink::Format::kBinary}};
+      for (const auto& format : formats) {
+	if (wanted(format.first))
+	  report(format.first, corpus, repeats, false, [&]() {
+	      WordSink sink(format.second);
+	      sink.open(dump_name);
+	      table.writeWords(sink);
+	      sink.close();
+	      return words;
+	    });
+      }
+      unlink(dump_name);
+    }
+
+    //counts the corpus again into a table that has already seen every word
+    //of it, which should only allocate per file, never per token
+    if (wanted("hashed_recount")) {
+      HashedSplays table(26);
+      table.processWordsFromFile(corpus.file_name);
+      report("hashed_recount", corpus, repeats, true, [&corpus, &table]() {
+	  table.processWordsFromFile(corpus.file_name);
+	  return static_cast<long>(corpus.tokens.size());
+	});
+    }
+  }
+
+  //the splay strategies again on LARGE_ZIPF_TOKENS words drawn from a 
+  //vocabulary of LARGE_ZIPF_VOCABULARY, only held as tokens
+  if (wanted_large("strategy_")) {
+    Corpus corpus;
+    corpus.name = "zipf5m";
+    std::mt19937 random(54321);
+    corpus.tokens = drawZipf(makeVocabulary(LARGE_ZIPF_VOCABULARY, random),
+			     LARGE_ZIPF_TOKENS, random);
+    benchmarkStrategies(corpus, repeats, filter);
+  }
+
+  //SORTED_WORDS distinct words inserted in sorted order, which leaves a 
+  //splay tree a single path, then searched for at random and walked in 
+  //order, with the depth bound off and on. Too large to repeat; the height 
+  //of the tree after each step goes to cerr, along with the deepest search
+  //and the number of rebuilds when built with WFC_STATS defined
+  if (wanted_large("depth_")) {
+    Corpus corpus;
+    corpus.name = "sorted10m";
+    std::vector<std::string> words(SORTED_WORDS);
+    char buffer[16];
+    for (int i = 0; i < SORTED_WORDS; ++i) {
+      std::snprintf(buffer, sizeof(buffer), "w%08d", i);
+      words[i] = buffer;
+    }
+    std::mt19937 random(12345);
+    std::uniform_int_distribution<int> uniform(0, SORTED_WORDS - 1);
+    //the words to search for, made before any clock starts
+    StringPool lookup_words;
+    std::vector<Node> lookups;
+    lookups.reserve(SORTED_LOOKUPS);
+    for (int i = 0; i < SORTED_LOOKUPS; ++i)
+      lookups.emplace_back(lookup_words, words[uniform(random)], 0);
+
+    for (int factor : {0, 2}) {
+      std::string suffix {factor ? "_bounded" : ""};
+      StringPool pool;
+      SplayTree<Node> tree;
+      tree.setDepthFactor(factor);
+      if (wanted("depth_insert" + suffix))
+	report("depth_insert" + suffix, corpus, 1, false, [&]() {
+	    for (const std::string& word : words)
+	      tree.upsert(PendingWord{word, &pool});
+	    return static_cast<long>(words.size());
+	  });
+      int inserted_height {tree.getHeight()};
+      if (wanted("depth_lookup" + suffix))
+	report("depth_lookup" + suffix, corpus, 1, false, [&]() {
+	    for (const Node& lookup : lookups)
+	      tree.splay(lookup);
+	    return static_cast<long>(lookups.size());
+	  });
+      int searched_height {tree.getHeight()};
+      if (wanted("depth_traverse" + suffix))
+	report("depth_traverse" + suffix, corpus, 1, false, [&tree]() {
+	    long count {0};
+	    tree.visitInOrder([&count](const Node&) {++count;});
+	    sink = count;
+	    return count;
+	  });
+      std::cerr << "depth" << suffix << ": height " << inserted_height
+		<< " after inserting, " << searched_height
+		<< " after searching, deepest search " 
+		<< tree.getStats().max_depth << ", " 
+		<< tree.getStats().rebuild_count << " rebuilds\n";
+    }
+  }
+
+  //only the generated corpora live in temporary files
+  for (const Corpus& corpus : corpora)
+    if (corpus.file_name != corpus.name)
+      unlink(corpus.file_name.c_str());
+  return 0;
+}
@@ -1,14 +1,36 @@
 //TODO: make a more interesting application of the HashedSplays class
 #include "hashed_splays.h" 
 #include <iostream>
+#include <cstdlib>
+#include <string>
 
 int main(int argc, char *argv[]) {
   const int ALPHABET_SIZE = 26; 
   
   //set up object to work on 
   HashedSplays word_frequecy(ALPHABET_SIZE);
-  //build the trees from words in the input file
-  word_frequecy.processWordsFromFile(argv[1]);
+  if (argc < 2) {
+    std::cerr << "usage: " << argv[0] << " <file | -> [threads]\n";
+    return 1;
+  }
+  
+  //"-" counts words piped into standard input, reporting as it goes
+  if (std::string(argv[1]) == "-") {
+    HashedSplays::StreamOptions options;
+    options.report_tokens = 1000000;
+    options.report_seconds = 5;
+    word_frequecy.processWordsFromStream(0, options, [](HashedSplays& table) {
+	table.printHashCountResults();
+	table.printTopWords(10);
+	std::cout << std::endl;
+      });
+  }
+  //build the trees from words in the input file, optionally with several
+  //threads given as the second argument
+  else {
+    int threads = argc > 2 ? std::atoi(argv[2]) : 1;
+    word_frequecy.processWordsFromFile(argv[1], threads);
+  }
   //few tests to show the results
   word_frequecy.printHashCountResults();
   word_frequecy.printTree(19); //19th character of alphabet is "t"
@@ -16,5 +38,10 @@ int main(int argc, char *argv[]) {
   word_frequecy.printTree(in_char);
   std::string test_str = "the";
   word_frequecy.findAll(test_str); // outputs all chars starting w/ "the"
+  word_frequecy.printTopWords(10);
   std::cout << '\n';
+#ifdef WFC_STATS
+  //builds with statistics compiled in also report what the counting cost
+  std::cout << word_frequecy.getStatsJson() << '\n';
+#endif
 }
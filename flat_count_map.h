@@ -0,0 +1,392 @@
+/** 
+ *
+ */
+#ifndef FLAT_COUNT_MAP_H_
+#define FLAT_COUNT_MAP_H_
+
+#include <algorithm>     // for min_element, partial_sort, sort
+#include <cstddef>       // for size_t
+#include <cstdint>       // for uint32_t, uint64_t
+#include <iostream>      // for cout
+#include <utility>       // for move, swap
+#include <vector>        // for vector
+
+#include "tree_stats.h"
+
+
+/** 
+ * FlatCountMap is an open addressing hash table with the counting interface 
+ *   of SplayTree, for a HashedSplays that only needs to count words as fast 
+ *   as possible. The elements live in a single array of slots probed one 
+ *   after another, next to an array holding 32 bits of the hash of each 
+ *   element, so a search reads consecutive tags and only compares the 
+ *   elements whose tag matches. The table doubles once it is three quarters 
+ *   full. The elements are kept in no order: visitInOrder and findAll sort 
+ *   what they visit first, so they cost O(n log n) instead of O(n). 
+ *   Besides "<", T must provide a static keyHash for T and for every key 
+ *   type passed to upsert, like Node. References to elements are 
+ *   invalidated when an element is added, since the table may grow. There 
+ *   is no splaying, so the splay count and TreeStats are always 0. 
+ */
+template <typename T>
+class FlatCountMap {
+ public:
+  /** 
+   * FlatCountMap no-arg constructor. 
+   *   Starts out with no slots allocated. 
+   */
+  FlatCountMap() : node_count_{0}, shift_{64} {}
+
+  /** 
+   * Finds the element equal to key, or inserts T(key) if there is none, 
+   *   and returns it. If the element was already present, its frequency 
+   *   counter is incremented. 
+   *   @param key The key to be counted. 
+   */
+  template <typename K>
+  const T& upsert(const K& key);
+
+  /** 
+   * Like upsert, but inserts a copy of element_in if it is not present and 
+   *   otherwise adds its frequency to the element already in the table. 
+   *   @param element_in The element whose count is to be added. 
+   */
+  const T& accumulate(const T& element_in);
+
+  /** 
+   * Returns the element equal to key, or nullptr if there is none. 
+   *   @param key The key to be looked up. 
+   */
+  template <typename K>
+  const T* lookup(const K& key) const;
+
+  /** 
+   * Returns true if there are no elements in the table. 
+   */
+  bool isEmpty() const {return node_count_ == 0;}
+
+  /** 
+   * Returns the number of elements in the table. 
+   */
+  int getNodeCount() const {return node_count_;}
+
+  /** 
+   * Returns 0, nothing is ever splayed. 
+   */
+  int getSplayCount() const {return 0;}
+
+  /** 
+   * Returns empty TreeStats, nothing is counted. 
+   */
+  TreeStats getStats() const {return TreeStats();}
+
+  /** 
+   * Prints every element in sorted order to the std output stream. 
+   */
+  void printTree() {
+    visitInOrder([](const T& element) {std::cout << element << "\n";});
+  }
+
+  /** 
+   * Inserts the smallest element into the std output stream, which is what 
+   *   a search of a sorted structure would start from. 
+   */
+  void printRoot() const;
+
+  /** 
+   * Calls visit on each element x of the table for which x.hasPrefix(prefix) 
+   *   is true, in sorted order. Every slot is looked at and the matches are 
+   *   sorted before they are visited. 
+   *   @param prefix What every element visited must start with. 
+   *   @param visit A function object taking a const T&. 
+   */
+  template <typename K, typename Visitor>
+  void findAll(const K& prefix, Visitor visit) const {
+    visitSorted([&prefix](const T& element) {
+	return element.hasPrefix(prefix);
+      }, visit);
+  }
+
+  /** 
+   * Calls visit on the k most frequent elements x of the table for which 
+   *   x.hasPrefix(prefix) is true, most frequent first and in sorted order 
+   *   among equal frequencies. Every slot is looked at and the matches are 
+   *   ranked. 
+   *   @param prefix What every element visited must start with. 
+   *   @param k The number of elements wanted. 
+   *   @param visit A function object taking a const T&. 
+   */
+  template <typename K, typename Visitor>
+  void findTop(const K& prefix, int k, Visitor visit) const;
+
+  /** 
+   * Calls visit on each element of the table in sorted order, sorting them 
+   *   first. 
+   *   @param visit A function object taking a const T&. 
+   */
+  template <typename Visitor>
+  void visitInOrder(Visitor visit) const {
+    visitSorted([](const T&) {return true;}, visit);
+  }
+
+  /** 
+   * Replaces the contents of the table with count elements, where element i 
+   *   is make(i). The elements must all be different. The table is sized 
+   *   for count elements once, so it never grows while they are added. 
+   *   @param count The number of elements in the new table. 
+   *   @param make A function object taking a std::size_t and returning a T. 
+   */
+  template <typename Make>
+  void buildFromSorted(std::size_t count, Make make);
+
+  /** 
+   * Merges the elements of other into this table: an element found in both 
+   *   keeps the one in this table with the frequency of the other one added 
+   *   to it, and an element only in other is added as adopt(element). 
+   *   other is not modified. 
+   *   @param other The table whose elements are to be merged in. 
+   *   @param adopt A function object taking a const T& and returning the T 
+   *     to be stored for it. 
+   */
+  template <typename Adopt>
+  void unite(const FlatCountMap& other, Adopt adopt);
+
+  /** 
+   * Merges the elements of other into this table as above, copying elements 
+   *   that are only in other as they are. 
+   *   @param other The table whose elements are to be merged in. 
+   */
+  void unite(const FlatCountMap& other) {
+    unite(other, [](const T& element) {return element;});
+  }
+
+ private:
+  static constexpr std::size_t MIN_CAPACITY = 16;
+
+  /** 
+   * Returns the tag stored for an element with hash. The tag leaves out the 
+   *   lowest bits, which pick the tree of a hashed HashedSplays and so are 
+   *   the same for every element of the table, and is never 0, which marks 
+   *   an empty slot. 
+   *   @param hash The hash of the element. 
+   */
+  static std::uint32_t tagOf(std::uint64_t hash) {
+    return static_cast<std::uint32_t>(hash >> 16) | 1;
+  }
+
+  /** 
+   * Returns the slot holding the element equal to key, or the empty slot 
+   *   where it would go if there is none. The table must have a free slot. 
+   *   @param key The key to be searched for. 
+   *   @param hash The keyHash of key. 
+   */
+  template <typename K>
+  std::size_t findSlot(const K& key, std::uint64_t hash) const;
+
+  /** 
+   * Puts element in the empty slot at index. Returns the element stored. 
+   *   @param index A slot returned by findSlot. 
+   *   @param hash The keyHash of element. 
+   *   @param element The element to be stored. 
+   */
+  T& fillSlot(std::size_t index, std::uint64_t hash, T&& element);
+
+  /** 
+   * Makes room for count elements without going over the maximum load, 
+   *   moving every element to a larger array of slots if needed. 
+   *   @param count The number of elements the table must be able to hold. 
+   */
+  void reserve(std::size_t count);
+
+  /** 
+   * Calls visit on every element for which keep returns true, in sorted 
+   *   order. 
+   *   @param keep A function object taking a const T& and returning bool. 
+   *   @param visit A function object taking a const T&. 
+   */
+  template <typename Keep, typename Visitor>
+  void visitSorted(Keep keep, Visitor& visit) const;
+
+  std::vector<T> slots_;            // the elements, where tags_ isn't 0
+  std::vector<std::uint32_t> tags_; // tagOf the hash of each slot, or 0
+  int node_count_;                  // number of slots in use
+  int shift_;                       // 64 minus log2 of the slot count
+};
+
+
+// Function definitions below
+
+template <typename T>
+template <typename K>
+const T& FlatCountMap<T>::upsert(const K& key) {
+  std::uint64_t hash {T::keyHash(key)};
+  std::size_t index {slots_.empty() ? 0 : findSlot(key, hash)};
+  if (!slots_.empty() && tags_[index]) {
+    slots_[index].incrementFrequency();
+    return slots_[index];
+  }
+  //the slot found may move when the table grows, so look again after it
+  if (static_cast<std::size_t>(node_count_ + 1) * 4 > slots_.size() * 3) {
+    reserve(node_count_ + 1);
+    index = findSlot(key, hash);
+  }
+  return fillSlot(index, hash, T(key));
+}
+
+template <typename T>
+const T& FlatCountMap<T>::accumulate(const T& element_in) {
+  std::uint64_t hash {T::keyHash(element_in)};
+  std::size_t index {slots_.empty() ? 0 : findSlot(element_in, hash)};
+  if (!slots_.empty() && tags_[index]) {
+    slots_[index].addFrequency(element_in.getFrequency());
+    return slots_[index];
+  }
+  if (static_cast<std::size_t>(node_count_ + 1) * 4 > slots_.size() * 3) {
+    reserve(node_count_ + 1);
+    index = findSlot(element_in, hash);
+  }
+  return fillSlot(index, hash, T(element_in));
+}
+
+template <typename T>
+template <typename K>
+const T* FlatCountMap<T>::lookup(const K& key) const {
+  if (slots_.empty())
+    return nullptr;
+  std::size_t index {findSlot(key, T::keyHash(key))};
+  return tags_[index] ? &slots_[index] : nullptr;
+}
+
+template <typename T>
+template <typename K>
+std::size_t FlatCountMap<T>::findSlot(const K& key,
+				      std::uint64_t hash) const {
+  //the highest bits pick the first slot to look at
+  std::size_t mask {slots_.size() - 1};
+  std::size_t index {static_cast<std::size_t>(hash >> shift_)};
+  std::uint32_t tag {tagOf(hash)};
+  while (tags_[index]) {
+    //neither is less than the other, so the slot holds key
+    if (tags_[index] == tag && !(key < slots_[index]) &&
+	!(slots_[index] < key))
+      break;
+    index = (index + 1) & mask;
+  }
+  return index;
+}
+
+template <typename T>
+T& FlatCountMap<T>::fillSlot(std::size_t index, std::uint64_t hash,
+			     T&& element) {
+  slots_[index] = std::move(element);
+  tags_[index] = tagOf(hash);
+  ++node_count_;
+  return slots_[index];
+}
+
+template <typename T>
+void FlatCountMap<T>::reserve(std::size_t count) {
+  std::size_t capacity {std::max(slots_.size(), MIN_CAPACITY)};
+  while (count * 4 > capacity * 3)
+    capacity *= 2;
+  if (capacity == slots_.size())
+    return;
+
+  std::vector<T> old_slots(capacity);
+  std::vector<std::uint32_t> old_tags(capacity, 0);
+  old_slots.swap(slots_);
+  old_tags.swap(tags_);
+  shift_ = 64;
+  for (std::size_t size = capacity; size > 1; size /= 2)
+    --shift_;
+  node_count_ = 0;
+  //the tags don't hold the bits that pick the slot, so hash again
+  for (std::size_t i = 0; i < old_slots.size(); ++i) {
+    if (old_tags[i]) {
+      std::uint64_t hash {T::keyHash(old_slots[i])};
+      fillSlot(findSlot(old_slots[i], hash), hash, std::move(old_slots[i]));
+    }
+  }
+}
+
+template <typename T>
+void FlatCountMap<T>::printRoot() const {
+  std::vector<const T*> elements;
+  for (std::size_t i = 0; i < slots_.size(); ++i)
+    if (tags_[i])
+      elements.push_back(&slots_[i]);
+  if (!elements.empty())
+    std::cout << **std::min_element(elements.begin(), elements.end(),
+				    [](const T* a, const T* b) {
+				      return *a < *b;
+				    });
+}
+
+template <typename T>
+template <typename Keep, typename Visitor>
+void FlatCountMap<T>::visitSorted(Keep keep, Visitor& visit) const {
+  std::vector<const T*> elements;
+  for (std::size_t i = 0; i < slots_.size(); ++i)
+    if (tags_[i] && keep(slots_[i]))
+      elements.push_back(&slots_[i]);
+  std::sort(elements.begin(), elements.end(),
+	    [](const T* a, const T* b) {return *a < *b;});
+  for (const T* element : elements)
+    visit(*element);
+}
+
+template <typename T>
+template <typename Make>
+void FlatCountMap<T>::buildFromSorted(std::size_t count, Make make) {
+  slots_.clear();
+  tags_.clear();
+  node_count_ = 0;
+  shift_ = 64;
+  reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    T element {make(i)};
+    std::uint64_t hash {T::keyHash(element)};
+    fillSlot(findSlot(element, hash), hash, std::move(element));
+  }
+}
+
+template <typename T>
+template <typename Adopt>
+void FlatCountMap<T>::unite(const FlatCountMap& other, Adopt adopt) {
+  if (this == &other)
+    return;
+  reserve(node_count_ + other.node_count_);
+  for (std::size_t i = 0; i < other.slots_.size(); ++i) {
+    if (!other.tags_[i])
+      continue;
+    const T& element {other.slots_[i]};
+    std::uint64_t hash {T::keyHash(element)};
+    std::size_t index {findSlot(element, hash)};
+    if (tags_[index])
+      slots_[index].addFrequency(element.getFrequency());
+    else
+      fillSlot(index, hash, adopt(element));
+  }
+}
+
+template <typename T>
+template <typename K, typename Visitor>
+void FlatCountMap<T>::findTop(const K& prefix, int k, Visitor visit) const {
+  std::vector<const T*> matches;
+  for (std::size_t i = 0; i < slots_.size(); ++i)
+    if (tags_[i] && slots_[i].hasPrefix(prefix))
+      matches.push_back(&slots_[i]);
+  auto more_frequent = [](const T* a, const T* b) {
+    if (a->getFrequency() != b->getFrequency())
+      return a->getFrequency() > b->getFrequency();
+    return *a < *b;
+  };
+  std::size_t count {std::min(matches.size(),
+			      static_cast<std::size_t>(std::max(k, 0)))};
+  std::partial_sort(matches.begin(), matches.begin() + count, matches.end(),
+		    more_frequent);
+  for (std::size_t i = 0; i < count; ++i)
+    visit(*matches[i]);
+}
+
+#endif //  FLAT_COUNT_MAP_H_
@@ -1,66 +1,478 @@
+#include <fcntl.h>       // for open
+#include <unistd.h>      // for read, close
+
 #include <iostream>      // for cout, cerr
-#include <fstream>       // for ostream
-#include <string>        // for string, getline
-#include <sstream>       // for stringstream
+#include <sstream>       // for ostringstream
+#include <fstream>       // for ofstream
+#include <cstring>       // for memcpy, memcmp
+#include <string>        // for string
+#include <string_view>   // for string_view
 #include <vector>        // for vector
-#include <cctype>        // for isupper, islower, tolower
-#include <regex>         // for regex, regex_replace
-#include <algorithm>     // for max
+#include <cctype>        // for isalpha, toupper, tolower
+#include <cstdint>       // for uint64_t
+#include <algorithm>     // for max, min, lower_bound, sort, push_heap
+#include <memory>        // for shared_ptr, make_shared, atomic_load
+#include <thread>        // for thread
+#include <chrono>        // for steady_clock
+#include <cerrno>        // for errno, EINTR
+#include <utility>       // for as_const
 
 #include "hashed_splays.h"
+#include "mapped_file.h"
+#include "scan_kernel.h"
+#include "tokenizer.h"
+#include "word_sink.h"
+
+const int DEFAULT_MAX_LOAD = 16;  //average words per tree before doubling
+const int DEFAULT_TOP_CAPACITY = 100;  //most frequent words tracked
+
+//layout of a file written by saveToFile: a FileHeader, then the number of
+//records of each tree as uint64_t, then the FileRecords of every tree one
+//tree after another, each tree sorted by word, then the pool of characters
+//the records point into
+const char FILE_MAGIC[8] = {'W', 'F', 'C', 'T', 'A', 'B', 'L', 'E'};
+const std::uint32_t FILE_VERSION = 1;
 
-const int ALPHABET_SIZE = 26;  //splay tree for every alphabet char, no case
+struct FileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t bucketing;    // 0 for kFirstLetter, 1 for kHashed
+  std::uint64_t tree_count;
+  std::uint64_t word_count;
+  std::uint64_t pool_size;    // bytes of characters at the end of the file
+};
+
+struct FileRecord {
+  std::uint64_t offset;       // where the word starts in the pool
+  std::uint32_t length;       // number of characters in the word
+  std::uint32_t frequency;
+};
+
+//more frequent first, alphabetical among equal frequencies
+static bool moreFrequent(const Node& a, const Node& b) {
+  if (a.getFrequency() != b.getFrequency())
+    return a.getFrequency() > b.getFrequency();
+  return a < b;
+}
+
+//in_part with its first letter in uppercase and in lowercase, uppercase
+//first since it sorts before the lowercase, or just once if it has no case
+static std::vector<std::string> casePrefixes(const std::string& in_part) {
+  unsigned char first = in_part[0];
+  std::vector<std::string> prefixes{in_part, in_part};
+  prefixes[0][0] = static_cast<char>(toupper(first));
+  prefixes[1][0] = static_cast<char>(tolower(first));
+  if (prefixes[0] == prefixes[1])
+    prefixes.pop_back();
+  return prefixes;
+}
+
+//part in lowercase if the words were counted that way, as it is otherwise
+static std::string foldQuery(const std::string& part, bool fold_case) {
+  std::string folded {part};
+  if (fold_case)
+    for (char& c : folded)
+      c = ScanKernel::foldChar(c);
+  return folded;
+}
+
+//smallest power of two that is at least size, and at least 1
+static std::size_t roundUpToPowerOfTwo(int size) {
+  std::size_t power {1};
+  while (static_cast<long>(power) < size)
+    power *= 2;
+  return power;
+}
 
 //set table's size to 1 if size parameter is not positive
-HashedSplays::HashedSplays(int size) : table_(std::max(1, size)) {}
+template <typename Bucket>
+BasicHashedSplays<Bucket>::BasicHashedSplays(int size, Bucketing bucketing)
+  : table_(bucketing == Bucketing::kHashed ? roundUpToPowerOfTwo(size)
+	   : std::max(1, size)),
+    old_table_{},
+    migrate_index_{0},
+    bucketing_{bucketing},
+    max_load_{DEFAULT_MAX_LOAD},
+    fold_case_{false},
+    word_count_{0},
+    top_words_{DEFAULT_TOP_CAPACITY},
+    index_infixes_{false},
+    infix_index_{},
+    tokenizer_{},
+    phase_times_{},
+    retired_stats_{},
+    pool_{std::make_shared<StringPool>()} {}
+
+//the trees are copied as they are, then rebuilt over words in a new pool
+template <typename Bucket>
+BasicHashedSplays<Bucket>::BasicHashedSplays(const BasicHashedSplays& other)
+  : table_(other.table_),
+    old_table_(other.old_table_),
+    migrate_index_{other.migrate_index_},
+    bucketing_{other.bucketing_},
+    max_load_{other.max_load_},
+    fold_case_{other.fold_case_},
+    word_count_{other.word_count_},
+    top_words_{other.top_words_.getCapacity()},
+    index_infixes_{other.index_infixes_},
+    infix_index_{},
+    tokenizer_{},
+    phase_times_{other.phase_times_},
+    retired_stats_{other.retired_stats_},
+    pool_{std::make_shared<StringPool>()} {
+  internEveryWord();
+}
+
+template <typename Bucket>
+BasicHashedSplays<Bucket>& BasicHashedSplays<Bucket>::operator=(
+    const BasicHashedSplays& other) {
+  if (this != &other)
+    *this = BasicHashedSplays(other);
+  return *this;
+}
 
-HashedSplays::~HashedSplays() {}
+template <typename Bucket>
+BasicHashedSplays<Bucket>::~BasicHashedSplays() {}
 
-void HashedSplays::processWordsFromFile(std::string file_name) {
-  const int INITIAL_NODE_FREQ = 1;  //used when initializing new node
+template <typename Bucket>
+void BasicHashedSplays<Bucket>::internEveryWord() {
+  std::vector<Node> nodes;
+  for (std::vector<Bucket>* trees : {&table_, &old_table_})
+    for (Bucket& tree : *trees) {
+      nodes.clear();
+      tree.visitInOrder([&nodes](const Node& node) {nodes.push_back(node);});
+      tree.buildFromSorted(nodes.size(), [this, &nodes](std::size_t i) {
+	  return Node(*pool_, nodes[i].getWord(), nodes[i].getFrequency());
+	});
+    }
+  rebuildTracking();
+}
+
+template <typename Bucket>
+void BasicHashedSplays<Bucket>::processWordsFromFile(
+    const std::string& file_name) {
+  //regular files are scanned in place through a read-only mapping
+  MappedFile mapped_file;
+  WFC_STAT(auto open_start = std::chrono::steady_clock::now());
+  if (mapped_file.open(file_name)) {
+    WFC_STAT(phase_times_.io_seconds += elapsedSeconds(open_start));
+    tokenizer_.reset(mapped_file.begin(), mapped_file.end());
+    processWords(tokenizer_);
+    return;
+  }
 
+  //pipes and other non-regular files are read a block at a time instead
   //does nothing if file is invalid
-  std::ifstream in_file{file_name};
-  if(!in_file.is_open()) {
+  int file_descriptor {open(file_name.c_str(), O_RDONLY)};
+  if(file_descriptor < 0) {
     std::cerr << "Error in opening file!\n";
     return;
   }
-  
-  std::string file_line;
-  while(std::getline(in_file, file_line)) {
-    //stringstream used to parse through individual words in line
-    std::stringstream str_in{file_line};
-    //is good while there are words remaining to be parsed
-    while(str_in.good()) {
-      std::string word;
-      str_in >> word;
-      std::string formatted_word{formatString(word)};
-      Node new_node(formatted_word, INITIAL_NODE_FREQ);
-      if (formatted_word == "")
-	continue;
-      //send to splay tree at index defined by first letter of word
-      else if(!table_[getIndex(formatted_word[0])].contains(new_node))
-	table_[getIndex(formatted_word[0])].insert(new_node);
-      //word already exists in tree, increment frequency counter
-      else
-	table_[getIndex(formatted_word[0])].incrementValue();       
+  processWordsFromStream(file_descriptor, StreamOptions(), nullptr);
+  close(file_descriptor);
+}
+
+template <typename Bucket>
+void BasicHashedSplays<Bucket>::processWordsFromFile(
+    const std::string& file_name, int thread_count) {
+  MappedFile mapped_file;
+  WFC_STAT(auto open_start = std::chrono::steady_clock::now());
+  if (thread_count < 2 || !mapped_file.open(file_name)) {
+    processWordsFromFile(file_name);
+    return;
+  }
+  WFC_STAT(phase_times_.io_seconds += elapsedSeconds(open_start));
+
+  //cut the mapping into chunks, moving each cut forward to the next newline
+  //so that no word is split between two threads
+  std::vector<const char*> cuts{mapped_file.begin()};
+  for (int i = 1; i < thread_count; ++i) {
+    const char* cut {mapped_file.begin() + mapped_file.size() * i /
+		     thread_count};
+    cut = std::max(cut, cuts.back());
+    while (cut != mapped_file.end() && *cut != '\n')
+      ++cut;
+    cuts.push_back(cut);
+  }
+  cuts.push_back(mapped_file.end());
+
+  //every thread counts its chunk into a shard nobody else touches, with a 
+  //string pool of its own
+  std::vector<BasicHashedSplays> shards;
+  shards.reserve(thread_count);
+  for (int i = 0; i < thread_count; ++i) {
+    shards.emplace_back(static_cast<int>(table_.size()), bucketing_);
+    shards.back().setFoldCase(fold_case_);
+  }
+  std::vector<std::thread> workers;
+  for (int i = 0; i < thread_count; ++i) {
+    workers.emplace_back([&shards, &cuts, i]() {
+	Tokenizer tokenizer(cuts[i], cuts[i + 1]);
+	shards[i].processWords(tokenizer);
+      });
+  }
+  for (std::thread& worker : workers)
+    worker.join();
+
+  bool united {false};
+  for (const BasicHashedSplays& shard : shards) {
+    WFC_STAT(retired_stats_ += shard.getTreeStats());
+    WFC_STAT(phase_times_.io_seconds += shard.phase_times_.io_seconds);
+    WFC_STAT(phase_times_.tokenize_seconds +=
+	     shard.phase_times_.tokenize_seconds);
+    WFC_STAT(phase_times_.tree_update_seconds +=
+	     shard.phase_times_.tree_update_seconds);
+    if (uniteTrees(shard))
+      united = true;
+    else
+      mergeCounts(shard);
+  }
+  //every frequency may have changed, so the leaders are found again, once
+  //for all the shards instead of once per shard
+  if (united)
+    rebuildTracking();
+}
+
+template <typename Bucket>
+void BasicHashedSplays<Bucket>::processWordsFromStream(
+    int file_descriptor, const StreamOptions& options,
+    const std::function<void(BasicHashedSplays&)>& report) {
+  std::vector<char> buffer(std::max<std::size_t>(1, options.block_size));
+  std::size_t filled {0};   //bytes in buffer, starting with carried ones
+  long tokens_since_report {0};
+  auto last_report = std::chrono::steady_clock::now();
+
+  while (true) {
+    WFC_STAT(auto read_start = std::chrono::steady_clock::now());
+    ssize_t bytes_read {read(file_descriptor, buffer.data() + filled,
+			     buffer.size() - filled)};
+    WFC_STAT(phase_times_.io_seconds += elapsedSeconds(read_start));
+    if (bytes_read < 0 && errno == EINTR)
+      continue;
+    if (bytes_read < 0) {
+      std::cerr << "Error in reading stream!\n";
+      break;
+    }
+    bool at_end {bytes_read == 0};
+    filled += bytes_read;
+
+    //only words followed by whitespace are known to be complete, the rest
+    //is carried over to the front of the buffer for the next read
+    std::size_t complete {filled};
+    if (!at_end) {
+      while (complete > 0 && !Tokenizer::isSpace(buffer[complete - 1]))
+	--complete;
+      //a single word fills the buffer, count what we have of it
+      if (complete == 0 && filled == buffer.size())
+	complete = filled;
+    }
+    tokenizer_.reset(buffer.data(), buffer.data() + complete);
+    tokens_since_report += processWords(tokenizer_);
+    std::copy(buffer.begin() + complete, buffer.begin() + filled,
+	      buffer.begin());
+    filled -= complete;
+
+    if (report) {
+      double seconds {std::chrono::duration<double>(
+	  std::chrono::steady_clock::now() - last_report).count()};
+      if ((options.report_tokens > 0 &&
+	   tokens_since_report >= options.report_tokens) ||
+	  (options.report_seconds > 0 && seconds >= options.report_seconds)) {
+	report(*this);
+	tokens_since_report = 0;
+	last_report = std::chrono::steady_clock::now();
+      }
+    }
+    if (at_end)
+      break;
+  }
+}
+
+template <typename Bucket>
+long BasicHashedSplays<Bucket>::processWords(Tokenizer& tokenizer) {
+  //tokenizer hands back each word with special chars removed
+  tokenizer.setFoldCase(fold_case_);
+  long word_count {0};
+  std::string_view word;
+  WFC_STAT(auto loop_start = std::chrono::steady_clock::now());
+  WFC_STAT(double tree_update_seconds {0});
+  while(tokenizer.next(word)) {
+    WFC_STAT(auto count_start = std::chrono::steady_clock::now());
+    countWord(word);
+    WFC_STAT(tree_update_seconds += elapsedSeconds(count_start));
+    ++word_count;
+  }
+  //whatever time was not spent in the trees went to the tokenizer
+  WFC_STAT(phase_times_.tree_update_seconds += tree_update_seconds);
+  WFC_STAT(phase_times_.tokenize_seconds +=
+	   elapsedSeconds(loop_start) - tree_update_seconds);
+  return word_count;
+}
+
+template <typename Bucket>
+void BasicHashedSplays<Bucket>::countWord(std::string_view word) {
+  growStep();
+  //send to splay tree at index defined by first letter of word, which
+  //inserts the word or increments its frequency if it already exists;
+  //the word is only copied into the pool the first time it is seen
+  Bucket& tree {treeFor(word)};
+  int node_count {tree.getNodeCount()};
+  const Node& counted {tree.upsert(PendingWord{word, pool_.get()})};
+  if (tree.getNodeCount() != node_count) {
+    ++word_count_;
+    if (index_infixes_)
+      infix_index_.add(counted.getWord());
+  }
+  top_words_.update(counted);
+}
+
+template <typename Bucket>
+void BasicHashedSplays<Bucket>::addCount(const Node& node) {
+  growStep();
+  //node's word lives in another table's pool, so it is counted once like a
+  //new word, which copies it into this pool if needed, then topped up 
+  //through the tree with a node for the copy
+  Bucket& tree {treeFor(node.getWord())};
+  int node_count {tree.getNodeCount()};
+  const Node* counted {&tree.upsert(PendingWord{node.getWord(), pool_.get()})};
+  if (node.getFrequency() > 1)
+    counted = &tree.accumulate(counted->withFrequency(node.getFrequency() -
+						      1));
+  if (tree.getNodeCount() != node_count) {
+    ++word_count_;
+    if (index_infixes_)
+      infix_index_.add(counted->getWord());
+  }
+  top_words_.update(*counted);
+}
+
+template <typename Bucket>
+void BasicHashedSplays<Bucket>::mergeCounts(const BasicHashedSplays& other) {
+  //other may be in the middle of a resize, so look at both of its tables
+  for (const std::vector<Bucket>* trees : {&other.table_, &other.old_table_}) {
+    for (const Bucket& tree : *trees)
+      tree.visitInOrder([this](const Node& node) {addCount(node);});
+  }
+}
+
+template <typename Bucket>
+void BasicHashedSplays<Bucket>::mergeFrom(const BasicHashedSplays& other) {
+  if (this == &other)
+    return;
+  if (uniteTrees(other))
+    rebuildTracking();
+  else
+    mergeCounts(other);
+}
+
+template <typename Bucket>
+bool BasicHashedSplays<Bucket>::uniteTrees(const BasicHashedSplays& other) {
+  if (bucketing_ != other.bucketing_ || table_.size() != other.table_.size()
+      || !old_table_.empty() || !other.old_table_.empty())
+    return false;
+
+  //the trees line up, so each is merged with its counterpart in one pass
+  word_count_ = 0;
+  for (std::size_t i = 0; i < table_.size(); ++i) {
+    table_[i].unite(other.table_[i], [this](const Node& node) {
+	return Node(*pool_, node.getWord(), node.getFrequency());
+      });
+    word_count_ += table_[i].getNodeCount();
+  }
+  return true;
+}
+
+template <typename Bucket>
+void BasicHashedSplays<Bucket>::rebuildTracking() {
+  setTopCapacity(top_words_.getCapacity());
+  setInfixIndexing(index_infixes_);
+}
+
+template <typename Bucket>
+Bucket& BasicHashedSplays<Bucket>::treeFor(std::string_view word) {
+  return const_cast<Bucket&>(std::as_const(*this).treeFor(word));
+}
+
+template <typename Bucket>
+const Bucket& BasicHashedSplays<Bucket>::treeFor(std::string_view word) const {
+  if (bucketing_ == Bucketing::kFirstLetter)
+    return table_[getIndex(word[0])];
+
+  std::size_t hash {hashWord(word)};
+  //words of old trees that haven't been moved yet are still in old_table_
+  if (!old_table_.empty()) {
+    std::size_t old_index {hash & (old_table_.size() - 1)};
+    if (old_index >= migrate_index_)
+      return old_table_[old_index];
+  }
+  return table_[hash & (table_.size() - 1)];
+}
+
+template <typename Bucket>
+void BasicHashedSplays<Bucket>::growStep() {
+  if (bucketing_ != Bucketing::kHashed)
+    return;
+
+  //move a single old tree per word added, so a resize is spread out
+  if (!old_table_.empty()) {
+    Bucket& old_tree {old_table_[migrate_index_++]};
+    old_tree.visitInOrder([this](const Node& node) {
+	table_[hashWord(node.getWord()) & (table_.size() - 1)].accumulate(node);
+      });
+    WFC_STAT(retired_stats_ += old_tree.getStats());
+    old_tree = Bucket();
+    if (migrate_index_ == old_table_.size()) {
+      old_table_.clear();
+      migrate_index_ = 0;
     }
   }
-  in_file.close();
+  //double the number of trees once they hold too many words on average
+  else if (word_count_ > static_cast<long>(max_load_) *
+	   static_cast<long>(table_.size())) {
+    old_table_.swap(table_);
+    table_ = std::vector<Bucket>(old_table_.size() * 2);
+    migrate_index_ = 0;
+  }
+}
+
+template <typename Bucket>
+void BasicHashedSplays<Bucket>::finishResize() {
+  while (!old_table_.empty())
+    growStep();
 }
 
-void HashedSplays::printTree(char letter) {
-  if (isalpha(letter)) {
+template <typename Bucket>
+void BasicHashedSplays<Bucket>::printTree(char letter) {
+  if (!isalpha(static_cast<unsigned char>(letter)))
+    std::cerr << "ERROR: invalid input to printTree(char)!\n";
+  else if (bucketing_ == Bucketing::kFirstLetter) {
     table_[getIndex(letter)].printTree();
     std::cout << "This tree has " << table_[getIndex(letter)].getSplayCount()
 	      << " splays.\n";
   }
-  else 
-    std::cerr << "ERROR: invalid input to printTree(char)!\n";
+  //words starting with letter are spread over every tree, so gather and
+  //sort them to print them in the same order as a single tree would
+  else {
+    finishResize();
+    char lower_letter = ScanKernel::foldChar(letter);
+    std::vector<Node> words;
+    for (const Bucket& tree : table_)
+      tree.visitInOrder([&words, lower_letter](const Node& node) {
+	  if (ScanKernel::foldChar(node.getWord()[0]) == lower_letter)
+	    words.push_back(node);
+	});
+    std::sort(words.begin(), words.end());
+    for (const Node& node : words)
+      std::cout << node << "\n";
+    std::cout << "These words are spread over " << table_.size()
+	      << " trees.\n";
+  }
 }
 
-void HashedSplays::printTree(int index) {
-  if (index < ALPHABET_SIZE) {
+template <typename Bucket>
+void BasicHashedSplays<Bucket>::printTree(int index) {
+  finishResize();
+  if (index >= 0 && index < getTreeCount()) {
     table_[index].printTree();
     std::cout << "This tree had " << table_[index].getSplayCount()
 	      << " splays.\n";
@@ -69,8 +481,10 @@ void HashedSplays::printTree(int index) {
     std::cerr << "ERROR: invalid input to printTree(int)!\n";
 }
 
-void HashedSplays::printHashCountResults() {
-  for (int i = 0; i < ALPHABET_SIZE; ++i) {
+template <typename Bucket>
+void BasicHashedSplays<Bucket>::printHashCountResults() {
+  finishResize();
+  for (std::size_t i = 0; i < table_.size(); ++i) {
     if (!table_[i].isEmpty()) {
       std::cout << "This tree starts with ";
       table_[i].printRoot();
@@ -81,28 +495,463 @@ void HashedSplays::printHashCountResults() {
   }
 }
 
-void HashedSplays::findAll(std::string in_part) {
+template <typename Bucket>
+bool BasicHashedSplays<Bucket>::saveToFile(const std::string& file_name) {
+  finishResize();
+  std::vector<std::uint64_t> tree_sizes;
+  std::vector<FileRecord> records;
+  std::string pool;
+  for (const Bucket& tree : table_) {
+    tree_sizes.push_back(tree.getNodeCount());
+    //in order visit gives the records of each tree in sorted order
+    tree.visitInOrder([&records, &pool](const Node& node) {
+	std::string_view word {node.getWord()};
+	FileRecord record;
+	record.offset = pool.size();
+	record.length = static_cast<std::uint32_t>(word.size());
+	record.frequency = static_cast<std::uint32_t>(node.getFrequency());
+	records.push_back(record);
+	pool += word;
+      });
+  }
+
+  FileHeader header;
+  std::memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+  header.version = FILE_VERSION;
+  header.bucketing = bucketing_ == Bucketing::kHashed ? 1 : 0;
+  header.tree_count = table_.size();
+  header.word_count = records.size();
+  header.pool_size = pool.size();
+
+  std::ofstream out_file{file_name, std::ios::binary | std::ios::trunc};
+  out_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out_file.write(reinterpret_cast<const char*>(tree_sizes.data()),
+		 tree_sizes.size() * sizeof(std::uint64_t));
+  out_file.write(reinterpret_cast<const char*>(records.data()),
+		 records.size() * sizeof(FileRecord));
+  out_file.write(pool.data(), pool.size());
+  out_file.close();
+  if (!out_file) {
+    std::cerr << "Error in writing file!\n";
+    return false;
+  }
+  return true;
+}
+
+template <typename Bucket>
+bool BasicHashedSplays<Bucket>::loadFromFile(const std::string& file_name) {
+  MappedFile mapped_file;
+  FileHeader header;
+  if (!mapped_file.open(file_name) || mapped_file.size() < sizeof(header)) {
+    std::cerr << "Error in opening file!\n";
+    return false;
+  }
+  std::memcpy(&header, mapped_file.begin(), sizeof(header));
+
+  //every section has to fit in the file exactly, checked without overflow
+  std::uint64_t remaining {mapped_file.size() - sizeof(header)};
+  bool valid {std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0 &&
+	      header.version == FILE_VERSION && header.bucketing <= 1 &&
+	      header.tree_count > 0 &&
+	      header.tree_count <= remaining / sizeof(std::uint64_t)};
+  if (valid) {
+    remaining -= header.tree_count * sizeof(std::uint64_t);
+    valid = header.word_count <= remaining / sizeof(FileRecord) &&
+      header.word_count * sizeof(FileRecord) + header.pool_size == remaining;
+  }
+  Bucketing bucketing {header.bucketing == 1 ? Bucketing::kHashed
+		       : Bucketing::kFirstLetter};
+  //hashed tables mask hashes with the number of trees, first letter ones
+  //need a tree for every letter
+  if (valid)
+    valid = bucketing == Bucketing::kHashed
+      ? (header.tree_count & (header.tree_count - 1)) == 0
+      : header.tree_count >= 26;
+  if (!valid) {
+    std::cerr << "Error in reading file, not a saved table!\n";
+    return false;
+  }
+
+  const char* tree_sizes {mapped_file.begin() + sizeof(header)};
+  const char* records {tree_sizes + header.tree_count * sizeof(std::uint64_t)};
+  const char* pool {records + header.word_count * sizeof(FileRecord)};
+  auto read_record = [records](std::uint64_t index) {
+    FileRecord record;
+    std::memcpy(&record, records + index * sizeof(FileRecord), sizeof(record));
+    return record;
+  };
+
+  //check every record before touching the table: it has to point inside the
+  //pool, be sorted within its tree, and belong in the tree it is saved in
+  std::vector<std::uint64_t> first_record(header.tree_count + 1, 0);
+  for (std::uint64_t i = 0; valid && i < header.tree_count; ++i) {
+    std::uint64_t tree_size;
+    std::memcpy(&tree_size, tree_sizes + i * sizeof(tree_size),
+		sizeof(tree_size));
+    valid = tree_size <= header.word_count - first_record[i];
+    first_record[i + 1] = valid ? first_record[i] + tree_size : 0;
+    std::string_view previous;
+    for (std::uint64_t r = first_record[i]; valid && r < first_record[i + 1];
+	 ++r) {
+      FileRecord record {read_record(r)};
+      valid = record.length > 0 && record.offset <= header.pool_size &&
+	record.length <= header.pool_size - record.offset;
+      if (!valid)
+	break;
+      std::string_view word(pool + record.offset, record.length);
+      valid = (r == first_record[i] || previous < word) &&
+	bucketIndex(word, bucketing, header.tree_count) == i;
+      previous = word;
+    }
+  }
+  if (!valid || first_record[header.tree_count] != header.word_count) {
+    std::cerr << "Error in reading file, saved table is corrupt!\n";
+    return false;
+  }
+
+  //the words are copied out of the mapping into a fresh pool, the old one 
+  //stays alive for as long as a snapshot still refers to it
+  std::shared_ptr<StringPool> new_pool {std::make_shared<StringPool>()};
+  std::vector<Bucket> new_table(header.tree_count);
+  for (std::uint64_t i = 0; i < header.tree_count; ++i) {
+    std::uint64_t first {first_record[i]};
+    new_table[i].buildFromSorted(first_record[i + 1] - first,
+				 [&read_record, &new_pool, pool, first](
+				     std::size_t r) {
+	FileRecord record {read_record(first + r)};
+	std::string_view word(pool + record.offset, record.length);
+	return Node(*new_pool, word, static_cast<int>(record.frequency));
+      });
+  }
+
+  table_.swap(new_table);
+  pool_ = new_pool;
+  old_table_.clear();
+  migrate_index_ = 0;
+  bucketing_ = bucketing;
+  word_count_ = static_cast<long>(header.word_count);
+  rebuildTracking();
+  return true;
+}
+
+template <typename Bucket>
+int BasicHashedSplays<Bucket>::getFrequency(std::string_view word) const {
+  if (word.empty())
+    return 0;
+  //words were counted in lowercase, so they are looked up that way too
+  std::string folded;
+  if (fold_case_) {
+    folded.reserve(word.size());
+    for (char c : word)
+      folded += ScanKernel::foldChar(c);
+    word = folded;
+  }
+  const Node* node {treeFor(word).lookup(word)};
+  return node ? node->getFrequency() : 0;
+}
+
+template <typename Bucket>
+std::vector<Node> BasicHashedSplays<Bucket>::complete(const std::string& prefix,
+						      int k) const {
+  std::vector<Node> top;
+  if (prefix.empty() || k <= 0)
+    return top;
+  std::string folded {foldQuery(prefix, fold_case_)};
+  auto keep = [&top](const Node& node) {top.push_back(node);};
+
+  //each tree hands over its own k best, the best k of those are the answer
+  std::vector<std::string> prefixes {casePrefixes(folded)};
+  if (bucketing_ == Bucketing::kFirstLetter) {
+    const Bucket& tree {table_[getIndex(folded[0])]};
+    for (const std::string& form : prefixes)
+      tree.findTop(std::string_view(form), k, keep);
+  }
+  else {
+    //words not yet migrated by a resize are still in old_table_
+    for (const std::vector<Bucket>* table : {&table_, &old_table_})
+      for (const Bucket& tree : *table)
+	for (const std::string& form : prefixes)
+	  tree.findTop(std::string_view(form), k, keep);
+  }
+  std::sort(top.begin(), top.end(), moreFrequent);
+  if (static_cast<int>(top.size()) > k)
+    top.erase(top.begin() + k, top.end());
+  return top;
+}
+
+template <typename Bucket>
+std::vector<Node> BasicHashedSplays<Bucket>::getTopWords(int k) {
+  if (k <= top_words_.getCapacity())
+    return top_words_.getTop(k);
+  return findTopWords(k);
+}
+
+template <typename Bucket>
+void BasicHashedSplays<Bucket>::printTopWords(int k) {
+  std::cout << "Printing the " << k << " most frequent words\n";
+  for (const Node& node : getTopWords(k))
+    std::cout << node << "\n";
+}
+
+template <typename Bucket>
+void BasicHashedSplays<Bucket>::setTopCapacity(int k) {
+  top_words_ = TopK(k);
+  for (const Node& node : findTopWords(top_words_.getCapacity()))
+    top_words_.update(node);
+}
+
+template <typename Bucket>
+void BasicHashedSplays<Bucket>::setInfixIndexing(bool enabled) {
+  index_infixes_ = enabled;
+  infix_index_.clear();
+  if (!enabled)
+    return;
+  for (const std::vector<Bucket>* trees : {&table_, &old_table_})
+    for (const Bucket& tree : *trees)
+      tree.visitInOrder([this](const Node& node) {
+	  infix_index_.add(node.getWord());
+	});
+}
+
+template <typename Bucket>
+std::vector<Node> BasicHashedSplays<Bucket>::findContaining(
+    const std::string& part) const {
+  std::vector<Node> words;
+  if (index_infixes_) {
+    //the index only knows the words, their counts are in the trees
+    infix_index_.findContaining(part, [this, &words](std::string_view word) {
+	words.push_back(*treeFor(word).lookup(word));
+      });
+  }
+  else {
+    for (const std::vector<Bucket>* trees : {&table_, &old_table_})
+      for (const Bucket& tree : *trees)
+	tree.visitInOrder([&part, &words](const Node& node) {
+	    if (Node::isInfix(part, node.getWord()))
+	      words.push_back(node);
+	  });
+  }
+  std::sort(words.begin(), words.end());
+  return words;
+}
+
+template <typename Bucket>
+std::vector<Node> BasicHashedSplays<Bucket>::findTopWords(int k) {
+  //min-heap of the k best words seen so far, the worst of them on top
+  finishResize();
+  std::vector<Node> top;
+  if (k <= 0)
+    return top;
+  for (const Bucket& tree : table_)
+    tree.visitInOrder([&top, k](const Node& node) {
+	if (static_cast<int>(top.size()) < k) {
+	  top.push_back(node);
+	  std::push_heap(top.begin(), top.end(), moreFrequent);
+	}
+	else if (moreFrequent(node, top.front())) {
+	  std::pop_heap(top.begin(), top.end(), moreFrequent);
+	  top.back() = node;
+	  std::push_heap(top.begin(), top.end(), moreFrequent);
+	}
+      });
+  std::sort_heap(top.begin(), top.end(), moreFrequent);
+  return top;
+}
+
+template <typename Bucket>
+void BasicHashedSplays<Bucket>::findAll(const std::string& in_part) {
   std::cout << "Printing the results of the nodes that start with '"
 	    << in_part << "'\n";
-  Node str_node(in_part, 1);
-  //SplayTree's findAll function does the printing
-  table_[getIndex(in_part[0])].findAll(str_node);
+  visitMatches(in_part, [](const Node& node) {std::cout << node << "\n";});
+}
+
+template <typename Bucket>
+bool BasicHashedSplays<Bucket>::writeMatches(const std::string& in_part,
+					     WordSink& sink) {
+  visitMatches(in_part, [&sink](const Node& node) {sink.write(node);});
+  return sink.flush();
+}
+
+template <typename Bucket>
+bool BasicHashedSplays<Bucket>::writeWords(WordSink& sink) {
+  //a table in the middle of a resize has words in both tables
+  for (const std::vector<Bucket>* trees : {&table_, &old_table_}) {
+    for (const Bucket& tree : *trees)
+      tree.visitInOrder([&sink](const Node& node) {sink.write(node);});
+  }
+  return sink.flush();
+}
+
+template <typename Bucket>
+template <typename Visitor>
+void BasicHashedSplays<Bucket>::visitMatches(const std::string& in_part,
+					     Visitor visit) {
+  if (in_part.empty())
+    return;
+
+  //words counted in lowercase are searched for that way too
+  std::string folded {foldQuery(in_part, fold_case_)};
+  std::vector<std::string> prefixes {casePrefixes(folded)};
+
+  if (bucketing_ == Bucketing::kFirstLetter) {
+    //both forms live in the tree of the first letter
+    Bucket& tree {table_[getIndex(folded[0])]};
+    for (const std::string& prefix : prefixes)
+      tree.findAll(std::string_view(prefix), visit);
+    return;
+  }
+
+  //matching words can be in any tree, gather and sort them
+  finishResize();
+  std::vector<Node> words;
+  for (const Bucket& tree : table_)
+    for (const std::string& prefix : prefixes)
+      tree.findAll(std::string_view(prefix), [&words](const Node& node) {
+	  words.push_back(node);
+	});
+  std::sort(words.begin(), words.end());
+  for (const Node& node : words)
+    visit(node);
+}
+
+template <typename Bucket>
+TreeStats BasicHashedSplays<Bucket>::getTreeStats() const {
+  TreeStats total {retired_stats_};
+  for (const std::vector<Bucket>* trees : {&table_, &old_table_}) {
+    for (const Bucket& tree : *trees)
+      total += tree.getStats();
+  }
+  return total;
+}
+
+template <typename Bucket>
+std::string BasicHashedSplays<Bucket>::getStatsJson() const {
+  std::ostringstream json;
+#ifdef WFC_STATS
+  json << "{\"stats_enabled\": true";
+#else
+  json << "{\"stats_enabled\": false";
+#endif
+  json << ", \"phases\": {\"io_seconds\": " << phase_times_.io_seconds
+       << ", \"tokenize_seconds\": " << phase_times_.tokenize_seconds
+       << ", \"tree_update_seconds\": " << phase_times_.tree_update_seconds
+       << "}, \"total\": " << getTreeStats().toJson() << ", \"trees\": [";
+  for (std::size_t i = 0; i < table_.size(); ++i) {
+    json << (i ? ", " : "") << "{\"index\": " << i
+	 << ", \"nodes\": " << table_[i].getNodeCount()
+	 << ", \"splays\": " << table_[i].getSplayCount()
+	 << ", \"stats\": " << table_[i].getStats().toJson() << "}";
+  }
+  json << "]}";
+  return json.str();
 }
 
-int HashedSplays::getIndex(char in_letter) {
-  if (isupper(in_letter))
-    return in_letter - 'A';
-  else if (islower(in_letter))
-    return in_letter - 'a';
+template <typename Bucket>
+void BasicHashedSplays<Bucket>::publishSnapshot() {
+  finishResize();
+  std::shared_ptr<const Snapshot> snapshot {
+    std::make_shared<Snapshot>(table_, bucketing_, pool_)};
+  std::atomic_store(&snapshot_, snapshot);
+}
+
+template <typename Bucket>
+std::shared_ptr<const typename BasicHashedSplays<Bucket>::Snapshot>
+BasicHashedSplays<Bucket>::getSnapshot() const {
+  return std::atomic_load(&snapshot_);
+}
+
+template <typename Bucket>
+BasicHashedSplays<Bucket>::Snapshot::Snapshot(
+    const std::vector<Bucket>& table, Bucketing bucketing,
+    std::shared_ptr<const StringPool> pool)
+  : trees_(table.size()), bucketing_{bucketing}, pool_{pool} {
+  for (std::size_t i = 0; i < table.size(); ++i) {
+    std::vector<Node>& tree {trees_[i]};
+    tree.reserve(table[i].getNodeCount());
+    //in order visit does not splay, so the live tree is left untouched
+    table[i].visitInOrder([&tree](const Node& node) {tree.push_back(node);});
+  }
+}
+
+template <typename Bucket>
+const Node* BasicHashedSplays<Bucket>::Snapshot::find(
+    std::string_view word) const {
+  std::size_t index {bucketIndex(word, bucketing_, trees_.size())};
+  if (index >= trees_.size())
+    return nullptr;
+  const std::vector<Node>& tree {trees_[index]};
+  auto it = std::lower_bound(tree.begin(), tree.end(), word,
+			     [](const Node& node, std::string_view key) {
+			       return node < key;
+			     });
+  if (it == tree.end() || word < *it)
+    return nullptr;
+  return &*it;
+}
+
+template <typename Bucket>
+std::vector<const Node*>
+BasicHashedSplays<Bucket>::Snapshot::prefixMatches(
+    std::string_view prefix) const {
+  std::vector<const Node*> matches;
+  if (prefix.empty())
+    return matches;
+
+  //with first letter trees only one tree can hold matches
+  std::size_t first {0};
+  std::size_t last {trees_.size()};
+  if (bucketing_ == Bucketing::kFirstLetter) {
+    first = bucketIndex(prefix, bucketing_, trees_.size());
+    last = std::min(first + 1, trees_.size());
+  }
+
+  for (std::size_t i = first; i < last; ++i) {
+    const std::vector<Node>& tree {trees_[i]};
+    //words starting with prefix are contiguous from the first one >= prefix
+    auto it = std::lower_bound(tree.begin(), tree.end(), prefix,
+			       [](const Node& node, std::string_view key) {
+				 return node < key;
+			       });
+    for (; it != tree.end() && it->hasPrefix(prefix); ++it)
+      matches.push_back(&*it);
+  }
+
+  //matches from several hashed trees have to be merged into one order
+  if (bucketing_ == Bucketing::kHashed)
+    std::sort(matches.begin(), matches.end(),
+	      [](const Node* a, const Node* b) {return *a < *b;});
+  return matches;
+}
+
+template <typename Bucket>
+std::size_t BasicHashedSplays<Bucket>::hashWord(std::string_view word) {
+  //the low bits pick the tree
+  return static_cast<std::size_t>(Node::keyHash(word));
+}
+
+template <typename Bucket>
+std::size_t BasicHashedSplays<Bucket>::bucketIndex(std::string_view word,
+						   Bucketing bucketing,
+						   std::size_t tree_count) {
+  if (word.empty())
+    return tree_count;
+  if (bucketing == Bucketing::kFirstLetter)
+    return getIndex(word[0]);
+  return hashWord(word) & (tree_count - 1);
+}
+
+template <typename Bucket>
+int BasicHashedSplays<Bucket>::getIndex(char in_letter) {
+  char letter {ScanKernel::foldChar(in_letter)};
+  if (letter >= 'a' && letter <= 'z')
+    return letter - 'a';
   else {
     std::cerr << "ERROR: bad input passed to getIndex\n";
     return 0;
   }
 }
 
-std::string HashedSplays::formatString(std::string in_str) {
-  //regex to filter out non-alphebetic characters
-  std::regex special_chars_re{R"(\W|\s|\d)"};
-  //removes special characters and returns formatted string
-  return std::regex_replace(in_str, special_chars_re, "");
-}
+//the bucket containers HashedSplays can be built with
+template class BasicHashedSplays<SplayTree<Node>>;
+template class BasicHashedSplays<FlatCountMap<Node>>;
+template class BasicHashedSplays<SortedBlockMap<Node>>;
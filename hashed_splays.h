@@ -5,43 +5,184 @@
 #ifndef HASHED_SPLAYS_H_
 #define HASHED_SPLAYS_H_
 
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "flat_count_map.h"
+#include "ngram_index.h"
 #include "node.h"
+#include "sorted_block_map.h"
 #include "splay_tree.h"
+#include "string_pool.h"
+#include "tokenizer.h"
+#include "top_k.h"
+#include "tree_stats.h"
+#include "word_sink.h"
 
 /** 
  * HashedSplays is a class that contains a vector that holds a splay tree for
  *   each letter of the alphabet. It provides a few operations for outputting 
  *   information about the splay trees and the contents of the nodes contained
- *   therein. 
+ *   therein. Alternatively the words can be spread over a power of two 
+ *   number of trees by a hash of the whole word, which grows as words are 
+ *   added. The characters of every word are stored once, in a StringPool 
+ *   that the nodes of the table and of its snapshots refer into. 
+ *   The container that holds the words of each bucket is the Bucket policy,
+ *   SplayTree<Node> for HashedSplays itself. FlatCountMap<Node> counts 
+ *   fastest but has to sort whenever the words are visited in order, and 
+ *   SortedBlockMap<Node> keeps them sorted in blocks for prefix and range 
+ *   queries. A Bucket is default constructible and copyable, and has 
+ *   upsert, accumulate, lookup, isEmpty, getNodeCount, getSplayCount, 
+ *   getStats, printTree, printRoot, findAll, visitInOrder, buildFromSorted 
+ *   and unite, with the meaning they have in SplayTree. Every Bucket the 
+ *   program uses is instantiated at the end of hashed_splays.cpp. 
+ *   A table is not thread safe: counting, merging and every query but the 
+ *   ones on a Snapshot must come from one thread at a time. Each table owns
+ *   its StringPool, and copies get a pool of their own, so different 
+ *   tables, copies included, can be used from different threads at once; 
+ *   the shards of a parallel count are such tables. Only snapshots share 
+ *   the pool of their table, for reading, which StringPool allows while 
+ *   the table keeps adding words. 
  */
-class HashedSplays {
+template <typename Bucket>
+class BasicHashedSplays {
  public:
+  class Snapshot;
+
+  /** 
+   * Bucketing selects how words are assigned to the trees in table_. 
+   *   kFirstLetter uses one tree per letter of the alphabet, picked by the 
+   *   first letter of the word regardless of case. kHashed picks the tree by
+   *   a hash of the whole word, and doubles the number of trees whenever 
+   *   the average tree holds more than the maximum load. 
+   */
+  enum class Bucketing {kFirstLetter, kHashed};
+
   /** 
-   * HashedSplays 1-arg constructor. 
+   * StreamOptions controls how processWordsFromStream reads its input and 
+   *   how often it reports on its progress. A report is due once either 
+   *   limit is reached; a limit of 0 is never reached. 
+   */
+  struct StreamOptions {
+    std::size_t block_size = 65536;  // bytes read at a time, the buffer size
+    long report_tokens = 0;          // words counted between reports
+    double report_seconds = 0;       // seconds between reports
+  };
+
+  /** 
+   * PhaseTimes holds the wall clock time spent in each phase of counting 
+   *   words, summed over every call. It is only filled in when the program
+   *   is built with WFC_STATS defined. When a file is memory mapped its 
+   *   pages are read while it is being tokenized, so io only covers opening
+   *   and mapping it. The time of every word is measured separately, so the
+   *   cost of reading the clock is part of tokenize and tree_update. 
+   *   Threads counting a file in parallel add up their own times. 
+   */
+  struct PhaseTimes {
+    double io_seconds = 0;           // opening, mapping and reading input
+    double tokenize_seconds = 0;     // splitting the input into words
+    double tree_update_seconds = 0;  // counting the words in the trees
+  };
+
+  /** 
+   * HashedSplays 1 or 2-arg constructor. 
    *   Initializes table to be of the size indicated by the size parameter. 
    *   Will initialize to a vector of size 1 if the input parameter is not 
-   *   a positive value. 
+   *   a positive value. With kHashed bucketing the size is rounded up to 
+   *   the next power of two. 
    *   @param size What the size of the table member variable should be. 
+   *   @param bucketing How words are assigned to trees. 
    */
-  HashedSplays(int size);
+  BasicHashedSplays(int size, Bucketing bucketing = Bucketing::kFirstLetter);
+  
+  /** 
+   * HashedSplays copy constructor. 
+   *   Makes a deep copy of the trees of other, with every word copied into 
+   *   a StringPool of its own, so the copy shares nothing with other and 
+   *   the two can be used from different threads. The tracked words and 
+   *   the infix index are rebuilt over the copied words, and the copy has 
+   *   no published snapshot. 
+   *   @param other The table whose contents are to be copied. 
+   */
+  BasicHashedSplays(const BasicHashedSplays& other);
+  
+  /** 
+   * HashedSplays move constructor. 
+   *   Takes over the trees and the StringPool of other, which is left 
+   *   empty. 
+   *   @param other The table whose contents are to be moved. 
+   */
+  BasicHashedSplays(BasicHashedSplays&& other) = default;
+  
+  /** 
+   * Assignment operator. 
+   *   Replaces the contents of this table with a deep copy of other, like 
+   *   the copy constructor. 
+   *   @param other The table whose contents are to be copied. 
+   */
+  BasicHashedSplays& operator=(const BasicHashedSplays& other);
+  
+  /** 
+   * Move assignment operator. 
+   *   Replaces the contents of this table with those of other, taking over
+   *   its StringPool. 
+   *   @param other The table whose contents are to be moved. 
+   */
+  BasicHashedSplays& operator=(BasicHashedSplays&& other) = default;
   
   /** 
    * HashedSplays destructor. 
    *   Currently does nothing extra besides the default. 
    */
-  ~HashedSplays();
+  ~BasicHashedSplays();
   
   /** 
    * Collects all of the words in the file specified by file_name, and 
    *   puts them in the appropriate splay tree in table_ as a node. Increments
-   *   the frequency of the word if it is already in a tree. 
+   *   the frequency of the word if it is already in a tree. Regular files 
+   *   are memory mapped and scanned in place; anything else, such as a pipe,
+   *   is read in fixed size blocks by processWordsFromStream. 
    *   @param file_name The name of the file to collect words from. Function 
    *     will do nothing if the file_name is invalid. 
    */
-  void processWordsFromFile(std::string file_name);
+  void processWordsFromFile(const std::string& file_name);
+  
+  /** 
+   * Collects all of the words in the file specified by file_name like the 
+   *   1-arg version, but splits the file into thread_count newline aligned 
+   *   chunks that are counted by separate threads. Each thread counts into 
+   *   its own private HashedSplays, and the trees of those shards are merged
+   *   into table_ once every thread is done, so no locking is needed. The 
+   *   resulting word frequencies are identical to the serial version. Files
+   *   that cannot be memory mapped are processed serially. 
+   *   @param file_name The name of the file to collect words from. 
+   *   @param thread_count The number of threads to count with. Values below
+   *     2 process the file serially. 
+   */
+  void processWordsFromFile(const std::string& file_name, int thread_count);
+  
+  /** 
+   * Collects all of the words that can be read from file_descriptor until 
+   *   end of file, such as standard input or a FIFO, and counts them like 
+   *   processWordsFromFile. Input is read in blocks of options.block_size 
+   *   bytes into a buffer of that size. A word cut off at the end of a block
+   *   is carried over to the next one, unless it fills the whole buffer, in
+   *   which case it is counted in pieces. After each block, report is called
+   *   if options.report_tokens words or options.report_seconds seconds have 
+   *   gone by since the last report, so results can be looked at while the 
+   *   input keeps coming. 
+   *   @param file_descriptor Where the words are read from. 
+   *   @param options The block size and the report intervals. 
+   *   @param report Called with this table whenever a report is due. 
+   */
+  void processWordsFromStream(
+      int file_descriptor, const StreamOptions& options,
+      const std::function<void(BasicHashedSplays&)>& report);
   
   /** 
    * Prints the contents of the tree containing every word that begins with 
@@ -68,12 +209,181 @@ class HashedSplays {
    */
   void printHashCountResults();
   
+  /** 
+   * Returns the number of times word was counted, or 0 if it never was. The
+   *   word is folded to lowercase first if the table counts in lowercase. 
+   *   The trees are not splayed or otherwise modified. 
+   *   @param word The word to be looked up. 
+   */
+  int getFrequency(std::string_view word) const;
+  
+  /** 
+   * Returns the k most frequent words that begin with prefix, most frequent 
+   *   first and alphabetical among equal frequencies, for autocompletion. 
+   *   The first letter is matched regardless of case, like findAll does. 
+   *   Each tree only looks at the part of itself that can still hold one 
+   *   of its k best matches, so a short prefix with many matches costs 
+   *   about k searches per tree rather than a visit to every match. 
+   *   @param prefix What every word returned must start with. 
+   *   @param k The number of words wanted. 
+   */
+  std::vector<Node> complete(const std::string& prefix, int k) const;
+  
+  /** 
+   * Returns the k most frequent words counted so far, most frequent first.
+   *   If k is no more than the number of words tracked while counting, the 
+   *   answer comes straight from the tracked leaders in O(k) time. Larger 
+   *   values of k fall back to a single pass over every tree. 
+   *   @param k The number of words wanted. 
+   */
+  std::vector<Node> getTopWords(int k);
+  
+  /** 
+   * Prints the k most frequent words counted so far, most frequent first. 
+   *   @param k The number of words to be printed. 
+   */
+  void printTopWords(int k);
+  
+  /** 
+   * Sets the number of most frequent words that are tracked while counting,
+   *   and rebuilds the tracked words from the trees. 0 turns tracking off. 
+   *   @param k The number of words to track. 
+   */
+  void setTopCapacity(int k);
+  
+  /** 
+   * Turns the infix index on or off. Turning it on builds it from the 
+   *   trees, and while it is on every new word is added to it as it is 
+   *   counted, so findContaining only checks the words that share the 
+   *   rarest trigram of its query. 
+   *   @param enabled Whether the index is kept. 
+   */
+  void setInfixIndexing(bool enabled);
+  
+  /** 
+   * Returns every word that contains part anywhere in it, regardless of 
+   *   case, with its frequency, in sorted order. Uses the infix index if 
+   *   it is on, and looks at every word of every tree otherwise. 
+   *   @param part What every word returned must contain. 
+   */
+  std::vector<Node> findContaining(const std::string& part) const;
+  
   /** 
    * Prints every node whose word begins with the string specified by the 
-   *   input parameter. 
+   *   input parameter, in sorted order. The first letter is matched 
+   *   regardless of case, like the choice of tree, and the rest exactly. 
+   *   If the table counts in lowercase, in_part is folded to lowercase 
+   *   first, so any case of a counted word finds it. 
    *   @in_part Specifies what every word to be printed must start with
    */
-  void findAll(std::string in_part);
+  void findAll(const std::string& in_part);
+  
+  /** 
+   * Writes every word that begins with in_part to sink, in the same order 
+   *   as findAll prints them, and flushes it. Returns false if writing 
+   *   failed. 
+   *   @param in_part What every word written must start with. 
+   *   @param sink Where the words are written. 
+   */
+  bool writeMatches(const std::string& in_part, WordSink& sink);
+  
+  /** 
+   * Writes every word in the table to sink, tree by tree with the words of 
+   *   each tree in sorted order, and flushes it. Returns false if writing 
+   *   failed. 
+   *   @param sink Where the words are written. 
+   */
+  bool writeWords(WordSink& sink);
+  
+  /** 
+   * Builds an immutable copy of every tree in table_ and publishes it as 
+   *   the current snapshot, replacing the previous one atomically. Readers 
+   *   that still hold the previous snapshot keep using it until they let go.
+   *   Must be called from the thread that modifies the table. 
+   */
+  void publishSnapshot();
+  
+  /** 
+   * Returns the most recently published snapshot, or nullptr if none has 
+   *   been published yet. Safe to call from any number of threads while the
+   *   writer keeps modifying table_. 
+   */
+  std::shared_ptr<const Snapshot> getSnapshot() const;
+  
+  /** 
+   * Writes every word in the table with its frequency to the binary file 
+   *   file_name, so the table can later be restored by loadFromFile without
+   *   counting the words again. The file holds a pool with the characters 
+   *   of every word, and for each tree its words in sorted order as 
+   *   (offset, length, frequency) records into the pool. Numbers are 
+   *   stored in the byte order of the machine. Returns false if the file 
+   *   could not be written. 
+   *   @param file_name The name of the file to be written. 
+   */
+  bool saveToFile(const std::string& file_name);
+  
+  /** 
+   * Replaces the contents of the table with the words saved in file_name by
+   *   saveToFile, taking on the bucketing and number of trees it was saved 
+   *   with. The file is memory mapped, and since the records of each tree 
+   *   are sorted every tree is rebuilt balanced in linear time instead of 
+   *   by inserting the words one at a time. Returns false and leaves the 
+   *   table unchanged if the file cannot be read or is not a valid save. 
+   *   @param file_name The name of the file to be loaded. 
+   */
+  bool loadFromFile(const std::string& file_name);
+  
+  /** 
+   * Adds the counts of every word in other to this table, inserting the 
+   *   words that are not here yet. When both tables use the same bucketing 
+   *   and number of trees and neither is in the middle of a resize, every 
+   *   tree is merged with its counterpart by SplayTree::unite in linear 
+   *   time and comes out balanced; otherwise the words of other are counted 
+   *   again one at a time. Words are copied into this table's pool, so 
+   *   other may go away afterwards. 
+   *   @param other The table whose counts are to be merged into this one. 
+   */
+  void mergeFrom(const BasicHashedSplays& other);
+  
+  /** 
+   * Sets the average number of words per tree above which a kHashed table 
+   *   doubles its number of trees. Has no effect on kFirstLetter tables. 
+   *   @param max_load The new maximum load. Values below 1 are set to 1. 
+   */
+  void setMaxLoad(int max_load) {max_load_ = std::max(1, max_load);}
+  
+  /** 
+   * Sets whether words read from now on are folded to lowercase before 
+   *   they are counted, so that "The" and "the" count as one word. Off by 
+   *   default. 
+   *   @param fold_case True to count every word in lowercase. 
+   */
+  void setFoldCase(bool fold_case) {fold_case_ = fold_case;}
+  
+  /** 
+   * Returns the number of trees in table_. 
+   */
+  int getTreeCount() const {return static_cast<int>(table_.size());}
+  
+  /** 
+   * Returns the TreeStats of every tree added together, including trees 
+   *   that were emptied by a resize and the shards of a parallel count. All
+   *   counts are 0 unless the program is built with WFC_STATS defined. 
+   */
+  TreeStats getTreeStats() const;
+  
+  /** 
+   * Returns the time spent in each phase of counting so far. All times are
+   *   0 unless the program is built with WFC_STATS defined. 
+   */
+  PhaseTimes getPhaseTimes() const {return phase_times_;}
+  
+  /** 
+   * Returns every statistic as a JSON object: whether statistics were 
+   *   compiled in, the phase timings, the totals of getTreeStats, and the 
+   *   node count, splay count and TreeStats of each tree in table_. 
+   */
+  std::string getStatsJson() const;
   
  private:
   /** 
@@ -82,20 +392,236 @@ class HashedSplays {
    *   @param in_letter The letter for which the index of the corresponding
    *    tree is desired. 
    */
-  int getIndex(char in_letter);
+  static int getIndex(char in_letter);
+  
+  /** 
+   * Returns a hash of every character in word. 
+   *   @param word The word to be hashed. 
+   */
+  static std::size_t hashWord(std::string_view word);
+  
+  /** 
+   * Returns the index of the tree that word belongs in, for a table of 
+   *   tree_count trees assigned by bucketing. Returns tree_count if word is 
+   *   empty. 
+   *   @param word The word whose tree is wanted. 
+   *   @param bucketing How words are assigned to trees. 
+   *   @param tree_count The number of trees, a power of two for kHashed. 
+   */
+  static std::size_t bucketIndex(std::string_view word, Bucketing bucketing,
+				 std::size_t tree_count);
+  
+  /** 
+   * Returns the tree that word belongs in. While a kHashed table is being 
+   *   resized, that is the tree in old_table_ if it has not been moved yet. 
+   *   @param word The word whose tree is wanted, must not be empty. 
+   */
+  Bucket& treeFor(std::string_view word);
+  const Bucket& treeFor(std::string_view word) const;
+  
+  /** 
+   * Does the bookkeeping of a kHashed table before a word is added: moves 
+   *   one tree of old_table_ into table_ if a resize is under way, and 
+   *   starts a resize if the table is over its maximum load. 
+   */
+  void growStep();
+  
+  /** 
+   * Moves every tree left in old_table_ into table_, so that table_ holds 
+   *   every word. 
+   */
+  void finishResize();
   
   /** 
-   * Removes any non-alphabetic characters from the input string. 
-   *   @param in_str The letter for which special characters are to be removed. 
+   * Inserts word in its tree, or increments its frequency if it is already 
+   *   there. 
+   *   @param word The word to be counted, must not be empty. 
    */
-  std::string formatString(std::string in_str);
+  void countWord(std::string_view word);
+  
+  /** 
+   * Adds the frequency of node to the same word in its tree, inserting a 
+   *   copy of node if the word is not there yet. 
+   *   @param node The word and count to be added. 
+   */
+  void addCount(const Node& node);
+  
+  /** 
+   * Copies the word of every node into pool_, which must not hold them yet,
+   *   and points the nodes at the copies, then rebuilds the tracked words 
+   *   and the infix index over them with rebuildTracking. 
+   */
+  void internEveryWord();
+  
+  /** 
+   * Returns the k most frequent words in every tree, most frequent first, 
+   *   by a full pass over the trees. 
+   *   @param k The number of words wanted. 
+   */
+  std::vector<Node> findTopWords(int k);
+
+  /** 
+   * Puts every word the tokenizer produces in the appropriate splay tree, 
+   *   incrementing the frequency of words that are already in a tree. 
+   *   Returns the number of words counted. 
+   *   @param tokenizer The tokenizer positioned over the words to be counted.
+   */
+  long processWords(Tokenizer& tokenizer);
+  
+  /** 
+   * Adds the frequency of every word in the trees of other to the word in 
+   *   the tree at the same index in table_, inserting words that are not in 
+   *   table_ yet. 
+   *   @param other The table whose counts are to be merged into this one. 
+   */
+  void mergeCounts(const BasicHashedSplays& other);
 
-  // Contains splay tree for each alphabetic character.
-  std::vector<SplayTree<Node>> table_;   
+  /** 
+   * Merges every tree of other into the tree at the same index with 
+   *   SplayTree::unite and returns true, or returns false and changes 
+   *   nothing if the two tables don't line up tree for tree. The tracked 
+   *   words and the infix index are left out of date, so several tables can
+   *   be merged before rebuildTracking is called once. 
+   *   @param other The table whose trees are to be merged into this one. 
+   */
+  bool uniteTrees(const BasicHashedSplays& other);
+
+  /** 
+   * Rebuilds the tracked words and the infix index from the trees, after 
+   *   their words or frequencies changed wholesale. 
+   */
+  void rebuildTracking();
+  
+  /** 
+   * Calls visit on every word that begins with in_part, with its first 
+   *   letter in either case, uppercase ones first and in sorted order 
+   *   otherwise. 
+   *   @param in_part What every word visited must start with. 
+   *   @param visit A function object taking a const Node&. 
+   */
+  template <typename Visitor>
+  void visitMatches(const std::string& in_part, Visitor visit);
+
+  // Contains splay tree for each alphabetic character, or for each hash
+  // bucket with kHashed bucketing.
+  std::vector<Bucket> table_;   
+  
+  // Trees of a kHashed table that is being resized; the trees before
+  // migrate_index_ have already been moved into table_.
+  std::vector<Bucket> old_table_;
+  std::size_t migrate_index_;
+  
+  Bucketing bucketing_;  // how words are assigned to trees
+  int max_load_;         // average words per tree that triggers a resize
+  bool fold_case_;       // whether words are counted in lowercase
+  long word_count_;      // number of distinct words, kept for kHashed
+  TopK top_words_;       // most frequent words, updated as words are counted
+  bool index_infixes_;   // whether infix_index_ is kept
+  NgramIndex infix_index_;  // trigrams of every word, if index_infixes_
+  
+  // Tokenizer of serial counts, kept so that counting words that were seen
+  // before, with words as long as before, allocates nothing.
+  Tokenizer tokenizer_;
+  
+  // Statistics, only collected when built with WFC_STATS defined.
+  PhaseTimes phase_times_;
+  TreeStats retired_stats_;  // counts of trees no longer in the table
+  
+  // Characters of every word in the table, shared with the snapshots.
+  std::shared_ptr<StringPool> pool_;
+  
+  // Last snapshot published, only accessed through std::atomic_load/store.
+  std::shared_ptr<const Snapshot> snapshot_;
                                          
   // int trees_;                       
   
 };
 
 
+/** 
+ * Snapshot is a read-only copy of every tree in a HashedSplays table, taken
+ *   at the moment it was published. The words of each tree are kept in a 
+ *   sorted array, so lookups never modify anything, and any number of 
+ *   threads can query a snapshot at the same time without locking. 
+ */
+template <typename Bucket>
+class BasicHashedSplays<Bucket>::Snapshot {
+ public:
+  /** 
+   * Snapshot 3-arg constructor. 
+   *   Copies the nodes of every tree in table, in sorted order. The nodes 
+   *   refer to their words in pool, which is kept alive by the snapshot. 
+   *   @param table The trees to be copied. 
+   *   @param bucketing How words were assigned to the trees in table. 
+   *   @param pool The pool holding the words of table. 
+   */
+  Snapshot(const std::vector<Bucket>& table, Bucketing bucketing,
+	   std::shared_ptr<const StringPool> pool);
+  
+  /** 
+   * Returns the number of trees the snapshot was taken of. 
+   */
+  int getTreeCount() const {return static_cast<int>(trees_.size());}
+  
+  /** 
+   * Returns the number of words in the tree at position index. 
+   *   @param index The position of the tree in the table. 
+   */
+  int getNodeCount(int index) const {
+    return static_cast<int>(trees_[index].size());
+  }
+  
+  /** 
+   * Returns the node holding word, or nullptr if word was not counted. 
+   *   @param word The word to be looked up. 
+   */
+  const Node* find(std::string_view word) const;
+  
+  /** 
+   * Calls visit on every node of the tree at position index in sorted 
+   *   order. 
+   *   @param index The position of the tree in the table. 
+   *   @param visit A function object taking a const Node&. 
+   */
+  template <typename Visitor>
+  void visitTree(int index, Visitor visit) const {
+    for (const Node& node : trees_[index])
+      visit(node);
+  }
+  
+  /** 
+   * Calls visit on every node whose word begins with prefix, in sorted 
+   *   order. 
+   *   @param prefix What every word visited must start with. 
+   *   @param visit A function object taking a const Node&. 
+   */
+  template <typename Visitor>
+  void findAll(std::string_view prefix, Visitor visit) const {
+    for (const Node* node : prefixMatches(prefix))
+      visit(*node);
+  }
+  
+ private:
+  /** 
+   * Returns every node whose word begins with prefix, in sorted order. 
+   *   With kHashed bucketing the matches of every tree are merged. 
+   *   @param prefix What every word returned must start with. 
+   */
+  std::vector<const Node*> prefixMatches(std::string_view prefix) const;
+  
+  // Sorted copy of the words of each tree in the table.
+  std::vector<std::vector<Node>> trees_;
+  Bucketing bucketing_;  // how words were assigned to trees
+  std::shared_ptr<const StringPool> pool_;  // holds the words of trees_
+};
+
+
+// HashedSplays with its default splay tree buckets, and the other bucket
+// containers, all instantiated in hashed_splays.cpp.
+using HashedSplays = BasicHashedSplays<SplayTree<Node>>;
+extern template class BasicHashedSplays<SplayTree<Node>>;
+extern template class BasicHashedSplays<FlatCountMap<Node>>;
+extern template class BasicHashedSplays<SortedBlockMap<Node>>;
+
+
 #endif //HASHED_SPLAYS_H_
@@ -0,0 +1,611 @@
+/** 
+ *
+ */
+#ifndef INDEXED_SPLAY_TREE_H_
+#define INDEXED_SPLAY_TREE_H_
+
+#include <cstddef>       // for size_t
+#include <cstdint>       // for uint32_t, uint64_t
+#include <iostream>      // for cout
+#include <utility>       // for move
+#include <vector>        // for vector
+
+#include "tree_stats.h"
+
+
+/** 
+ * IndexedSplayTree is a splay tree laid out for fewer cache misses, kept 
+ *   for bench.cpp to compare with SplayTree. Instead of vertices spread 
+ *   over the heap, the links of every vertex are kept together in one 
+ *   vector and address each other by 32-bit index, along with a prefix of 
+ *   the key packed into a number. The elements themselves live apart in a 
+ *   second vector at the same index, so a descent only reads the 24 byte 
+ *   links and compares prefixes, and touches an element only when the 
+ *   prefixes are equal.
+ *   Its interface is only the counting and visiting part of SplayTree's: 
+ *   insert, upsert, accumulate, remove, splay, findAll, visitInOrder and 
+ *   buildFromSorted. It has no lookup, findTop, split, join, unite, depth 
+ *   bound or splay strategy, so it is not a Bucket of BasicHashedSplays. 
+ *   Besides "<" and "==", T must provide a static keyPrefix for T and for
+ *   every key type passed to upsert, returning a number whose order 
+ *   agrees with the order of the keys whenever two numbers differ.
+ *   References to elements are invalidated when an element is added, since
+ *   the vectors may grow.
+ */
+template <typename T>
+class IndexedSplayTree {
+ public:
+  /** 
+   * IndexedSplayTree no-arg constructor.
+   *   Sets up an empty tree, and counter values to 0.
+   */
+  IndexedSplayTree();
+
+  /** 
+   * Inserts the element into the splay tree. Splays the tree afterwards to
+   *   make the vertex containing element_in the root.
+   *   @param element_in The object to be inserted into the splay tree.
+   */
+  void insert(const T& element_in) {insert(T(element_in));}
+
+  /** 
+   * Moves the element into the splay tree, otherwise like insert above.
+   *   @param element_in The object to be moved into the splay tree.
+   */
+  void insert(T&& element_in);
+
+  /** 
+   * Finds the element equal to key, or inserts T(key) if there is none, in
+   *   a single descent, and splays it to the root. If the element was
+   *   already present, its frequency counter is incremented. Returns a
+   *   reference to the element, valid until the next element is added.
+   *   @param key The key to be counted.
+   */
+  template <typename K>
+  T& upsert(const K& key);
+
+  /** 
+   * Like upsert, but inserts a copy of element_in if it is not present and
+   *   otherwise adds its frequency to the element already in the tree.
+   *   @param element_in The element whose count is to be added.
+   */
+  T& accumulate(const T& element_in);
+
+  /** 
+   * Removes the element equal to element from the tree, if there is one.
+   *   Its slot is reused by the next element added.
+   *   @param element The object to be removed.
+   */
+  void remove(const T& element);
+
+  /** 
+   * Returns true if an element equal to element is in the tree.
+   *   @param element The object to be searched for.
+   */
+  bool contains(const T& element) {return findVertex(element) != kNone;}
+
+  /** 
+   * Returns true if the tree has no elements.
+   */
+  bool isEmpty() const {return node_count_ == 0;}
+
+  /** 
+   * Prints each element in the tree in sorted order to the std output
+   *   stream.
+   */
+  void printTree();
+
+  /** 
+   * Returns the number of splay steps performed, where a zig-zig or zig-zag
+   *   step counts once even though it makes two rotations.
+   */
+  int getSplayCount() const {return splay_counter_;}
+
+  /** 
+   * Returns the rotation, comparison and depth counts of the tree, which
+   *   are all 0 unless the program is built with WFC_STATS defined. Only
+   *   comparisons of whole elements are counted, not those of prefixes.
+   */
+  TreeStats getStats() const {
+#ifdef WFC_STATS
+    return stats_;
+#else
+    return TreeStats();
+#endif
+  }
+
+  /** 
+   * Increments the frequency counter of the element at the root.
+   */
+  void incrementValue() {elements_[root_].incrementFrequency();}
+
+  /** 
+   * Returns the number of elements in the tree.
+   */
+  int getNodeCount() const {return node_count_;}
+
+  /** 
+   * Prints the element at the root of the tree, if there is one.
+   */
+  void printRoot() const;
+
+  /** 
+   * Calls visit, in sorted order and without splaying, on every element
+   *   that begins with prefix, like SplayTree::findAll.
+   *   @param prefix What every element visited must start with.
+   *   @param visit A function object taking a const T&.
+   */
+  template <typename K, typename Visitor>
+  void findAll(const K& prefix, Visitor visit) const;
+
+  /** 
+   * Calls visit on every element in sorted order, without splaying.
+   *   @param visit A function object taking a const T&.
+   */
+  template <typename Visitor>
+  void visitInOrder(Visitor visit) const {visitInOrder(visit, root_);}
+
+  /** 
+   * Replaces the contents of the tree with count elements, where element i
+   *   is make(i), produced in sorted order, as a perfectly balanced tree.
+   *   @param count The number of elements in the new tree.
+   *   @param make A function object taking a std::size_t and returning a T.
+   */
+  template <typename Make>
+  void buildFromSorted(std::size_t count, Make make);
+
+  /** 
+   * Splays the vertex holding the element equal to element_in to the root,
+   *   if there is one.
+   *   @param element_in The object to be splayed.
+   */
+  void splay(const T& element_in);
+
+ private:
+  //index standing in for a missing child, parent or root
+  static const std::uint32_t kNone = 0xffffffff;
+
+  /** 
+   * Link is the part of a vertex read on every descent: the packed prefix
+   *   of its element and the indexes of its children and parent.
+   */
+  struct Link {
+    std::uint64_t prefix;
+    std::uint32_t left_child;
+    std::uint32_t right_child;
+    std::uint32_t parent;
+  };
+
+  /** 
+   * Stores element in a free slot, reusing one left by remove if there is
+   *   one, with no children and the given parent. Returns its index.
+   *   @param element The element to be stored.
+   *   @param prefix The keyPrefix of element.
+   *   @param parent The index of the parent of the new vertex.
+   */
+  std::uint32_t newVertex(T element, std::uint64_t prefix,
+			  std::uint32_t parent);
+
+  /** 
+   * Rotates the vertex at index up over its parent, preserving the order
+   *   of the tree.
+   *   @param index The vertex to be rotated up.
+   */
+  void rotateUp(std::uint32_t index);
+
+  /** 
+   * Performs the splay operation on the vertex at index, rotating it up
+   *   until it becomes the root of the tree.
+   *   @param index The vertex to be set as the root of the tree.
+   */
+  void splayVertex(std::uint32_t index);
+
+  /** 
+   * Searches the tree for the vertex whose element is equal to key in a
+   *   single descent, creating a vertex holding T(key) where the search
+   *   ended if there is none, then splays it to the root and returns its
+   *   index.
+   *   @param key The object to be searched for in the tree.
+   *   @param found Set to true if the vertex was already in the tree.
+   */
+  template <typename K>
+  std::uint32_t findOrInsert(const K& key, bool& found);
+
+  /** 
+   * Returns the index of the vertex whose element is equal to element_in,
+   *   or kNone if there is none. Does not splay.
+   *   @param element_in The object to be searched for in the tree.
+   */
+  std::uint32_t findVertex(const T& element_in);
+
+  /** 
+   * Calls visit on the elements of the subtree at index in order.
+   *   @param visit A function object taking a const T&.
+   *   @param index The vertex whose subtree is to be visited.
+   */
+  template <typename Visitor>
+  void visitInOrder(Visitor& visit, std::uint32_t index) const;
+
+  /** 
+   * Builds a perfectly balanced subtree out of the elements make(first) up
+   *   to make(last - 1) and returns the index of its root.
+   *   @param make A function object taking a std::size_t and returning a T.
+   *   @param first The index of the smallest element of the subtree.
+   *   @param last One past the index of the largest element of the subtree.
+   *   @param parent The vertex the subtree will hang off of.
+   */
+  template <typename Make>
+  std::uint32_t buildRange(Make& make, std::size_t first, std::size_t last,
+			   std::uint32_t parent);
+
+  std::vector<Link> links_;            // hot part of every vertex
+  std::vector<T> elements_;            // cold part, at the same index
+  std::vector<std::uint32_t> free_;    // slots left behind by remove
+  std::uint32_t root_;                 // index of the root, or kNone
+  int splay_counter_;                  // splay steps performed on the tree
+  int node_count_;                     // number of elements in the tree
+#ifdef WFC_STATS
+  TreeStats stats_;                    // rotations, comparisons and depths
+#endif
+};
+
+
+// Function definitions below
+
+template <typename T>
+IndexedSplayTree<T>::IndexedSplayTree()
+  : links_{}, elements_{}, free_{}, root_{kNone}, splay_counter_{0},
+    node_count_{0} {}
+
+template <typename T>
+void IndexedSplayTree<T>::insert(T&& element_in) {
+  std::uint64_t prefix {T::keyPrefix(element_in)};
+  std::uint32_t current {root_};
+  std::uint32_t parent {kNone};
+  bool went_left {false};
+  WFC_STAT(int depth {0});
+  WFC_STAT(long comparisons {0});
+
+  //equal elements go to the right, like SplayTree::insert
+  while (current != kNone) {
+    parent = current;
+    if (prefix != links_[current].prefix)
+      went_left = prefix < links_[current].prefix;
+    else {
+      WFC_STAT(++comparisons);
+      went_left = element_in < elements_[current];
+    }
+    current = went_left ? links_[current].left_child
+                        : links_[current].right_child;
+    WFC_STAT(++depth);
+  }
+  WFC_STAT(stats_.recordAccess(depth, comparisons));
+
+  current = newVertex(std::move(element_in), prefix, parent);
+  if (parent == kNone)
+    root_ = current;
+  else if (went_left)
+    links_[parent].left_child = current;
+  else
+    links_[parent].right_child = current;
+  ++node_count_;
+  splayVertex(current);
+}
+
+template <typename T>
+template <typename K>
+T& IndexedSplayTree<T>::upsert(const K& key) {
+  bool found;
+  std::uint32_t index {findOrInsert(key, found)};
+  //element already in tree, bump its counter
+  if (found)
+    elements_[index].incrementFrequency();
+  return elements_[index];
+}
+
+template <typename T>
+T& IndexedSplayTree<T>::accumulate(const T& element_in) {
+  bool found;
+  std::uint32_t index {findOrInsert(element_in, found)};
+  //element already in tree, add the other count to it
+  if (found)
+    elements_[index].addFrequency(element_in.getFrequency());
+  return elements_[index];
+}
+
+template <typename T>
+template <typename K>
+std::uint32_t IndexedSplayTree<T>::findOrInsert(const K& key, bool& found) {
+  std::uint64_t prefix {T::keyPrefix(key)};
+  std::uint32_t current {root_};
+  std::uint32_t parent {kNone};
+  bool went_left {false};
+  WFC_STAT(int depth {0});
+  WFC_STAT(long comparisons {0});
+
+  //the whole elements are only compared once the prefixes are equal
+  while (current != kNone) {
+    const Link& link {links_[current]};
+    if (prefix != link.prefix)
+      went_left = prefix < link.prefix;
+    else if (key < elements_[current])
+      went_left = true;
+    else if (elements_[current] < key)
+      went_left = false;
+    //neither is less than the other, so current holds key
+    else
+      break;
+    //equal prefixes take one comparison to go left and two to go right
+    WFC_STAT(if (prefix == link.prefix) comparisons += went_left ? 1 : 2);
+    WFC_STAT(++depth);
+    parent = current;
+    current = went_left ? link.left_child : link.right_child;
+  }
+
+  found = current != kNone;
+  WFC_STAT(if (found) comparisons += 2);
+  if (!found) {
+    current = newVertex(T(key), prefix, parent);
+    if (parent == kNone)
+      root_ = current;
+    else if (went_left)
+      links_[parent].left_child = current;
+    else
+      links_[parent].right_child = current;
+    ++node_count_;
+  }
+
+  WFC_STAT(stats_.recordAccess(depth, comparisons));
+  splayVertex(current);
+  return current;
+}
+
+template <typename T>
+std::uint32_t IndexedSplayTree<T>::findVertex(const T& element_in) {
+  std::uint64_t prefix {T::keyPrefix(element_in)};
+  std::uint32_t current {root_};
+  WFC_STAT(int depth {0});
+  WFC_STAT(long comparisons {0});
+  while (current != kNone) {
+    const Link& link {links_[current]};
+    if (prefix != link.prefix)
+      current = prefix < link.prefix ? link.left_child : link.right_child;
+    else if (element_in == elements_[current])
+      break;
+    else {
+      current = element_in < elements_[current] ? link.left_child
+	                                        : link.right_child;
+      WFC_STAT(comparisons += 2);
+    }
+    WFC_STAT(++depth);
+  }
+  //the last == that found the element is a comparison too
+  WFC_STAT(if (current != kNone) stats_.recordAccess(depth, comparisons + 1));
+  return current;
+}
+
+template <typename T>
+void IndexedSplayTree<T>::remove(const T& element) {
+  std::uint32_t index {findVertex(element)};
+  if (index == kNone)
+    return;
+
+  //sets the vertex to be removed to root position
+  splayVertex(index);
+  std::uint32_t left {links_[index].left_child};
+  std::uint32_t right {links_[index].right_child};
+
+  //no left children
+  if (left == kNone) {
+    root_ = right;
+    if (root_ != kNone)
+      links_[root_].parent = kNone;
+  }
+  //left children only, or both: splay the largest left descendant to the
+  //top of the left subtree, where it has no right child, and hang the
+  //right subtree off of it
+  else {
+    root_ = left;
+    links_[root_].parent = kNone;
+    std::uint32_t left_max {root_};
+    while (links_[left_max].right_child != kNone)
+      left_max = links_[left_max].right_child;
+    splayVertex(left_max);
+    links_[left_max].right_child = right;
+    if (right != kNone)
+      links_[right].parent = left_max;
+  }
+
+  elements_[index] = T();
+  free_.push_back(index);
+  --node_count_;
+}
+
+template <typename T>
+std::uint32_t IndexedSplayTree<T>::newVertex(T element, std::uint64_t prefix,
+					     std::uint32_t parent) {
+  Link link {prefix, kNone, kNone, parent};
+  if (!free_.empty()) {
+    std::uint32_t index {free_.back()};
+    free_.pop_back();
+    links_[index] = link;
+    elements_[index] = std::move(element);
+    return index;
+  }
+  links_.push_back(link);
+  elements_.push_back(std::move(element));
+  return static_cast<std::uint32_t>(links_.size() - 1);
+}
+
+template <typename T>
+void IndexedSplayTree<T>::rotateUp(std::uint32_t index) {
+  std::uint32_t parent {links_[index].parent};
+  std::uint32_t grandparent {links_[parent].parent};
+
+  //the child of index that lies between index and parent changes sides
+  if (links_[parent].left_child == index) {
+    std::uint32_t middle {links_[index].right_child};
+    links_[parent].left_child = middle;
+    if (middle != kNone)
+      links_[middle].parent = parent;
+    links_[index].right_child = parent;
+  }
+  else {
+    std::uint32_t middle {links_[index].left_child};
+    links_[parent].right_child = middle;
+    if (middle != kNone)
+      links_[middle].parent = parent;
+    links_[index].left_child = parent;
+  }
+  links_[parent].parent = index;
+  links_[index].parent = grandparent;
+
+  //replace grandparent's relationship w/ parent to w/ index
+  if (grandparent == kNone)
+    root_ = index;
+  else if (links_[grandparent].left_child == parent)
+    links_[grandparent].left_child = index;
+  else
+    links_[grandparent].right_child = index;
+}
+
+template <typename T>
+void IndexedSplayTree<T>::splay(const T& element_in) {
+  std::uint32_t index {findVertex(element_in)};
+  if (index != kNone)
+    splayVertex(index);
+}
+
+template <typename T>
+void IndexedSplayTree<T>::splayVertex(std::uint32_t index) {
+  while (links_[index].parent != kNone) {
+    std::uint32_t parent {links_[index].parent};
+    std::uint32_t grandparent {links_[parent].parent};
+    //parent is the root
+    if (grandparent == kNone) {
+      rotateUp(index);
+      WFC_STAT(++stats_.zig_count);
+    }
+    //index and parent are children on the same side
+    else if ((links_[grandparent].left_child == parent) ==
+	     (links_[parent].left_child == index)) {
+      rotateUp(parent);
+      rotateUp(index);
+      WFC_STAT(++stats_.zig_zig_count);
+    }
+    //index and parent are children on opposite sides
+    else {
+      rotateUp(index);
+      rotateUp(index);
+      WFC_STAT(++stats_.zig_zag_count);
+    }
+    ++splay_counter_;
+  }
+}
+
+template <typename T>
+void IndexedSplayTree<T>::printTree() {
+  visitInOrder([](const T& element) {std::cout << element << "\n";});
+}
+
+template <typename T>
+void IndexedSplayTree<T>::printRoot() const {
+  if (root_ != kNone)
+    std::cout << elements_[root_];
+}
+
+template <typename T>
+template <typename K, typename Visitor>
+void IndexedSplayTree<T>::findAll(const K& prefix, Visitor visit) const {
+  //holds the vertices still to be visited, smallest on top
+  std::vector<std::uint32_t> pending;
+
+  //seek to the lower bound of prefix, keeping each vertex we pass on the
+  //left since those are the ones that come after it in order
+  std::uint32_t current {root_};
+  while (current != kNone) {
+    if (elements_[current] < prefix)
+      current = links_[current].right_child;
+    else {
+      pending.push_back(current);
+      current = links_[current].left_child;
+    }
+  }
+
+  //walk in order until an element no longer starts with prefix
+  while (!pending.empty()) {
+    current = pending.back();
+    pending.pop_back();
+    if (!elements_[current].hasPrefix(prefix))
+      return;
+    visit(elements_[current]);
+    for (current = links_[current].right_child; current != kNone;
+	 current = links_[current].left_child)
+      pending.push_back(current);
+  }
+}
+
+template <typename T>
+template <typename Visitor>
+void IndexedSplayTree<T>::visitInOrder(Visitor& visit,
+				       std::uint32_t index) const {
+  if (index == kNone)
+    return;
+  //climbs back up through parent indexes instead of recursing
+  std::uint32_t top {links_[index].parent};
+  while (links_[index].left_child != kNone)
+    index = links_[index].left_child;
+  while (index != top) {
+    visit(elements_[index]);
+    if (links_[index].right_child != kNone) {
+      index = links_[index].right_child;
+      while (links_[index].left_child != kNone)
+	index = links_[index].left_child;
+    }
+    else {
+      //coming up out of a right subtree means its parent was visited too
+      std::uint32_t child {index};
+      index = links_[index].parent;
+      while (index != top && links_[index].right_child == child) {
+	child = index;
+	index = links_[index].parent;
+      }
+    }
+  }
+}
+
+template <typename T>
+template <typename Make>
+void IndexedSplayTree<T>::buildFromSorted(std::size_t count, Make make) {
+  links_.clear();
+  elements_.clear();
+  free_.clear();
+  links_.reserve(count);
+  elements_.reserve(count);
+  root_ = buildRange(make, 0, count, kNone);
+  node_count_ = static_cast<int>(count);
+}
+
+//recursive function, depth is only log2 of the number of elements
+template <typename T>
+template <typename Make>
+std::uint32_t IndexedSplayTree<T>::buildRange(Make& make, std::size_t first,
+					      std::size_t last,
+					      std::uint32_t parent) {
+  if (first == last)
+    return kNone;
+  //build left to right so make is called with indexes in increasing order
+  std::size_t middle {first + (last - first) / 2};
+  std::uint32_t left {buildRange(make, first, middle, kNone)};
+  T element {make(middle)};
+  std::uint64_t prefix {T::keyPrefix(element)};
+  std::uint32_t index {newVertex(std::move(element), prefix, parent)};
+  links_[index].left_child = left;
+  if (left != kNone)
+    links_[left].parent = index;
+  std::uint32_t right {buildRange(make, middle + 1, last, index)};
+  links_[index].right_child = right;
+  return index;
+}
+
+#endif //  INDEXED_SPLAY_TREE_H_
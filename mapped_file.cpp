@@ -0,0 +1,44 @@
+#include <fcntl.h>       // for open
+#include <sys/mman.h>    // for mmap, madvise, munmap
+#include <sys/stat.h>    // for fstat
+#include <unistd.h>      // for close
+
+#include "mapped_file.h"
+
+MappedFile::MappedFile() : data_{nullptr}, size_{0} {}
+
+MappedFile::~MappedFile() {close();}
+
+bool MappedFile::open(const std::string& file_name) {
+  close();
+  int fd {::open(file_name.c_str(), O_RDONLY)};
+  if (fd < 0)
+    return false;
+
+  //pipes, devices and empty files can't be mapped, leave them to the caller
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode) ||
+      file_stat.st_size <= 0) {
+    ::close(fd);
+    return false;
+  }
+
+  std::size_t length {static_cast<std::size_t>(file_stat.st_size)};
+  void* mapping {mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0)};
+  //the mapping keeps its own reference to the file
+  ::close(fd);
+  if (mapping == MAP_FAILED)
+    return false;
+
+  madvise(mapping, length, MADV_SEQUENTIAL);
+  data_ = static_cast<const char*>(mapping);
+  size_ = length;
+  return true;
+}
+
+void MappedFile::close() {
+  if (data_)
+    munmap(const_cast<char*>(data_), size_);
+  data_ = nullptr;
+  size_ = 0;
+}
@@ -0,0 +1,72 @@
+/** 
+ *
+ */
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <cstddef>   // for size_t
+#include <string>    // for string
+
+/** 
+ * MappedFile maps the contents of a regular file into memory read-only, so
+ *   that the bytes can be scanned in place without being copied into 
+ *   strings. The kernel is told the mapping will be read sequentially. The 
+ *   mapping is released when the object is destroyed or closed. 
+ */
+class MappedFile {
+ public:
+  /** 
+   * MappedFile no-arg constructor. 
+   *   Starts out with nothing mapped. 
+   */
+  MappedFile();
+
+  /** 
+   * MappedFile destructor. 
+   *   Unmaps the file if one is mapped. 
+   */
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /** 
+   * Maps the file specified by file_name, unmapping any previous file. 
+   *   Returns false if the file cannot be opened, is not a regular file, 
+   *   is empty, or cannot be mapped, in which case the caller should fall 
+   *   back to reading it as a stream. 
+   *   @param file_name The name of the file to be mapped. 
+   */
+  bool open(const std::string& file_name);
+
+  /** 
+   * Unmaps the file if one is mapped. 
+   */
+  void close();
+
+  /** 
+   * Returns true if a file is currently mapped. 
+   */
+  bool isOpen() const {return data_ != nullptr;}
+
+  /** 
+   * Returns the first byte of the mapping, or nullptr if nothing is mapped. 
+   */
+  const char* begin() const {return data_;}
+
+  /** 
+   * Returns one past the last byte of the mapping. 
+   */
+  const char* end() const {return data_ + size_;}
+
+  /** 
+   * Returns the number of bytes that are mapped. 
+   */
+  std::size_t size() const {return size_;}
+
+ private:
+  const char* data_;   // start of the mapping, nullptr when closed
+  std::size_t size_;   // length of the mapping in bytes
+};
+
+#endif //MAPPED_FILE_H_
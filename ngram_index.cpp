@@ -0,0 +1,40 @@
+#include <cctype>      // for tolower
+
+#include "ngram_index.h"
+
+void NgramIndex::add(std::string_view word) {
+  std::uint32_t id {static_cast<std::uint32_t>(words_.size())};
+  words_.push_back(word);
+  for (std::size_t i = 0; i + 3 <= word.size(); ++i) {
+    std::vector<std::uint32_t>& posting {postings_[trigramAt(word.substr(i))]};
+    //a trigram that repeats in the word was already given its id
+    if (posting.empty() || posting.back() != id)
+      posting.push_back(id);
+  }
+}
+
+void NgramIndex::clear() {
+  words_.clear();
+  postings_.clear();
+}
+
+std::uint32_t NgramIndex::trigramAt(std::string_view text) {
+  std::uint32_t trigram {0};
+  for (std::size_t i = 0; i < 3; ++i)
+    trigram = trigram << 8 | static_cast<unsigned char>(
+	::tolower(static_cast<unsigned char>(text[i])));
+  return trigram;
+}
+
+const std::vector<std::uint32_t>*
+NgramIndex::findCandidates(std::string_view part) const {
+  const std::vector<std::uint32_t>* shortest {nullptr};
+  for (std::size_t i = 0; i + 3 <= part.size(); ++i) {
+    auto found = postings_.find(trigramAt(part.substr(i)));
+    if (found == postings_.end())
+      return nullptr;
+    if (!shortest || found->second.size() < shortest->size())
+      shortest = &found->second;
+  }
+  return shortest;
+}
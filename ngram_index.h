@@ -0,0 +1,103 @@
+/** 
+ *
+ */
+#ifndef NGRAM_INDEX_H_
+#define NGRAM_INDEX_H_
+
+#include <cstddef>        // for size_t
+#include <cstdint>        // for uint32_t
+#include <string_view>    // for string_view
+#include <unordered_map>  // for unordered_map
+#include <vector>         // for vector
+
+#include "node.h"
+
+/** 
+ * NgramIndex finds the words that contain a given string anywhere in them, 
+ *   regardless of case, like Node::operator%. Every word added gets an id, 
+ *   and every trigram (run of three characters, in lowercase) of the word 
+ *   gets the id appended to its posting list. A word containing a string of 
+ *   three or more characters contains each trigram of that string, so only 
+ *   the words in the shortest posting list among those trigrams need to be 
+ *   checked. Strings of one or two characters have no trigram and are 
+ *   checked against every word. Since ids are handed out in order, posting 
+ *   lists are sorted and a word is added to a list at most once. Words are 
+ *   referred to instead of copied, so they must outlive the NgramIndex, like 
+ *   the pooled words of HashedSplays. 
+ */
+class NgramIndex {
+ public:
+  /** 
+   * NgramIndex no-arg constructor. 
+   *   Starts out with no words. 
+   */
+  NgramIndex() = default;
+
+  /** 
+   * Adds word to the index. A word must not be added twice. 
+   *   @param word The word to be indexed, which must outlive the index. 
+   */
+  void add(std::string_view word);
+
+  /** 
+   * Calls visit on each word of the index that contains part regardless of
+   *   case, as Node::isInfix decides, in the order the words were added. 
+   *   @param part What every word visited must contain. 
+   *   @param visit A function object taking a std::string_view. 
+   */
+  template <typename Visitor>
+  void findContaining(std::string_view part, Visitor visit) const;
+
+  /** 
+   * Returns the number of words in the index. 
+   */
+  int getWordCount() const {return static_cast<int>(words_.size());}
+
+  /** 
+   * Forgets every word. 
+   */
+  void clear();
+
+ private:
+  /** 
+   * Returns the trigram of the three characters at the start of text, in 
+   *   lowercase, packed into one integer. 
+   *   @param text Where the trigram starts, at least three characters long. 
+   */
+  static std::uint32_t trigramAt(std::string_view text);
+
+  /** 
+   * Returns the ids of the words that may contain part, which is at least 
+   *   three characters long: the shortest posting list of its trigrams, or 
+   *   nullptr if one of them is in no word. 
+   *   @param part What the words must contain. 
+   */
+  const std::vector<std::uint32_t>* findCandidates(std::string_view part) const;
+
+  std::vector<std::string_view> words_;  // every word, indexed by id
+  // ids of the words that hold each trigram, in increasing order
+  std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> postings_;
+};
+
+
+// Function definitions below
+
+template <typename Visitor>
+void NgramIndex::findContaining(std::string_view part, Visitor visit) const {
+  if (part.size() < 3) {
+    for (std::string_view word : words_)
+      if (Node::isInfix(part, word))
+	visit(word);
+    return;
+  }
+  //a word can hold every trigram of part without holding part, so each one
+  //is checked
+  const std::vector<std::uint32_t>* candidates {findCandidates(part)};
+  if (!candidates)
+    return;
+  for (std::uint32_t id : *candidates)
+    if (Node::isInfix(part, words_[id]))
+      visit(words_[id]);
+}
+
+#endif //NGRAM_INDEX_H_
@@ -1,42 +1,91 @@
-#include <algorithm>
+#include <algorithm>   // for search
+#include <cctype>      // for tolower
 
 #include "node.h"
+#include "string_pool.h"
 
-Node::Node() : word_{}, frequency_{0} {}
+Node::Node() : word_{nullptr}, length_{0}, frequency_{0} {}
 
-Node::Node(std::string in_word, int freq) : word_{in_word}, frequency_{freq} {}
+Node::Node(std::string_view in_word, int freq)
+  : word_{in_word.data()},
+    length_{static_cast<std::uint32_t>(in_word.size())},
+    frequency_{freq} {}
 
-Node::~Node() {}
+Node::Node(StringPool& pool, std::string_view in_word, int freq)
+  : Node(pool.intern(in_word), freq) {}
 
-std::string Node::getWord() const {return word_;}
+Node::Node(const PendingWord& pending)
+  : Node(pending.pool->intern(pending.word), 1) {}
 
 int Node::getFrequency() const {return frequency_;}
 
 void Node::incrementFrequency() {++frequency_;}
 
-bool Node::operator<(const Node& other) const {return word_ < other.word_;}
+void Node::addFrequency(int count) {frequency_ += count;}
 
-bool Node::operator==(const Node& other) const {return word_ == other.word_;}
+bool Node::operator<(const Node& other) const {
+  return getWord() < other.getWord();
+}
+
+bool Node::operator<(std::string_view word) const {return getWord() < word;}
+
+bool operator<(std::string_view word, const Node& in_node) {
+  return word < in_node.getWord();
+}
 
-Node Node::operator=(const Node& other) {
+bool Node::operator==(const Node& other) const {
+  return getWord() == other.getWord();
+}
+
+Node& Node::operator=(const Node& other) {
   if (!(this == &other)) {
     word_ = other.word_;
+    length_ = other.length_;
     frequency_ = other.frequency_;
   }
   return *this;
 }
 
-bool Node::operator%(const Node& other) const {
-  //compares lowercase forms of words, transform converts each string to lower
-  std::string text {getWord()};
-  std::transform(text.begin(), text.end(), text.begin(), ::tolower);
-  std::string compared {other.getWord()};
-  std::transform(compared.begin(), compared.end(), compared.begin(), ::tolower);
+bool Node::hasPrefix(std::string_view prefix) const {
+  return getWord().compare(0, prefix.size(), prefix) == 0;
+}
+
+std::uint64_t Node::keyPrefix(std::string_view word) {
+  std::uint64_t prefix {0};
+  for (std::size_t i = 0; i < sizeof(prefix); ++i) {
+    unsigned char byte = i < word.size() ? word[i] : 0;
+    prefix = prefix << 8 | byte;
+  }
+  return prefix;
+}
+
+std::uint64_t Node::keyHash(std::string_view word) {
+  //64-bit FNV-1a over the characters
+  std::uint64_t hash {14695981039346656037ULL};
+  for (char c : word) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+  //final avalanche so the low bits depend on every char as well
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+bool Node::isInfix(std::string_view part, std::string_view word) {
+  //compares lowercase forms of words character by character, without making
+  //lowercase copies of them
+  auto same_lower = [](char a, char b) {
+    return ::tolower(static_cast<unsigned char>(a)) ==
+      ::tolower(static_cast<unsigned char>(b));
+  };
 
-  //returns false if node's word is not a substring of other's word
-  if(text.length() > compared.length())
+  //returns false if part is not a substring of word
+  if(part.length() > word.length())
     return false;
-  else if(!(text.find(compared)==std::string::npos))
+  else if(std::search(word.begin(), word.end(), part.begin(), part.end(),
+		      same_lower) == word.end())
     return false;
   else
     return true;
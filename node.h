@@ -4,14 +4,35 @@
 #ifndef NODE_H_
 #define NODE_H_
 
-#include <string>   //  for string
-#include <ostream>  //  for ostream
+#include <cstdint>      //  for uint64_t
+#include <string>       //  for string
+#include <string_view>  //  for string_view
+#include <ostream>      //  for ostream
+
+class StringPool;
+
+/** 
+ * PendingWord is a word that has not been stored anywhere yet, along with 
+ *   the pool it is to be copied into if a Node has to be made for it. It 
+ *   compares like the bare word, so a tree can search for it, and the word 
+ *   is only copied into the pool when the tree constructs a Node from it. 
+ */
+struct PendingWord {
+  std::string_view word;
+  StringPool* pool;
+
+  operator std::string_view() const {return word;}
+};
 
 /** 
  * Node is a class for storing words that are collected from a text file.
  * It stores the frequency of occurence of the stored word in the text file as
  * well. A few operations have been overloaded for this class for practice. They
  * are utilized in the HashedSplays class, as well as the SplayTree class.  
+ * The node does not own its word, it only holds where the characters are and 
+ * how many there are, so the word must outlive the node. A node is only 
+ * made over a word in a StringPool: the public constructors copy the word 
+ * into one first, so a node can't be left referring to a temporary string. 
  */
 class Node {
  public:
@@ -23,34 +44,58 @@ class Node {
   Node();
 
   /** 
-   * 2 argument Node constructor. 
-   *   Initializes word_ to in_word, and frequency_ to frequency. 
+   * 3 argument Node constructor. 
+   *   Copies in_word into pool and refers to the copy, and initializes 
+   *   frequency_ to frequency. 
+   *   @param pool       Where the word is copied, which must outlive the 
+   *     node. 
    *   @param in_word    A word from the text file. 
    *   @param frequency  The frequency that the word arises in the file. 
    */
-  Node(std::string in_word, int frequency);
+  Node(StringPool& pool, std::string_view in_word, int frequency);
+
+  /** 
+   * PendingWord Node constructor. 
+   *   Copies the pending word into its pool and refers to the copy, and 
+   *   initializes frequency_ to 1. 
+   *   @param pending    A word that was not counted before. 
+   */
+  explicit Node(const PendingWord& pending);
 
   /** 
    * Node Destructor. 
-   *   Currently does nothing beyond the default. 
+   *   Does nothing, so nodes can be dropped without being destroyed. 
    */
-  ~Node();
+  ~Node() = default;
   
   /** 
-   *  Returns the word stored in word_. 
+   *  Returns a view of the word. 
    */
-  std::string getWord() const;
+  std::string_view getWord() const {return std::string_view(word_, length_);}
   
   /** 
    * Returns the value stored in frequency_.
    */
   int getFrequency() const;
   
+  /** 
+   * Returns a node that refers to the same word, with frequency in place of
+   *   frequency_. 
+   *   @param frequency The frequency of the returned node. 
+   */
+  Node withFrequency(int frequency) const {return Node(getWord(), frequency);}
+  
   /** 
    * Increments the value of frequency_ by 1. 
    */
   void incrementFrequency();
   
+  /** 
+   * Adds count to the value of frequency_. 
+   *   @param count The number of further occurrences of the word. 
+   */
+  void addFrequency(int count);
+  
   /** 
    * < operator. 
    *   Compares the two strings in each node. 
@@ -58,6 +103,23 @@ class Node {
    *   @param other Node to compare this to. 
    */
   bool operator<(const Node& other) const;
+
+  /** 
+   * < operator. 
+   *   Compares the string in the node with a bare word. 
+   *   Returns true if word_ < word. 
+   *   @param word Word to compare this to. 
+   */
+  bool operator<(std::string_view word) const;
+
+  /** 
+   * < operator. 
+   *   Compares a bare word with the string in the node. 
+   *   Returns true if word < in_node.word_. 
+   *   @param word Word to compare in_node to. 
+   *   @param in_node Node to compare word to. 
+   */
+  friend bool operator<(std::string_view word, const Node& in_node);
   
   /** 
    * == operator. 
@@ -71,16 +133,66 @@ class Node {
    * Assignment operator. 
    *   Sets the value of word_ to other, and the value of frequency_ to 
    *   other.frequency_.
+   *   Returns a reference to this node, like the built in assignment. 
    *   @param other Node to compare this to. 
    */  
-  Node operator=(const Node& other);
+  Node& operator=(const Node& other);
+  
+  /** 
+   * Returns true if word_ begins with prefix. 
+   *   @param prefix The string the word is checked against. 
+   */
+  bool hasPrefix(std::string_view prefix) const;
+  
+  /** 
+   * Returns the first 8 bytes of word packed into a number, the first byte 
+   *   in the highest position and missing bytes as 0. Whenever the numbers 
+   *   of two words differ they are ordered like the words themselves, so 
+   *   the number can be compared instead of the whole word. 
+   *   @param word The word whose prefix is wanted. 
+   */
+  static std::uint64_t keyPrefix(std::string_view word);
+  
+  /** 
+   * Returns keyPrefix of the word stored in in_node. 
+   *   @param in_node The node whose prefix is wanted. 
+   */
+  static std::uint64_t keyPrefix(const Node& in_node) {
+    return keyPrefix(in_node.getWord());
+  }
+  
+  /** 
+   * Returns a 64-bit hash of every character of word, with every bit of 
+   *   the hash depending on every character, so any range of its bits can 
+   *   be used as an index. 
+   *   @param word The word to be hashed. 
+   */
+  static std::uint64_t keyHash(std::string_view word);
+  
+  /** 
+   * Returns keyHash of the word stored in in_node. 
+   *   @param in_node The node whose hash is wanted. 
+   */
+  static std::uint64_t keyHash(const Node& in_node) {
+    return keyHash(in_node.getWord());
+  }
   
   /** 
    * % operator. 
    *   Returns true if lowercase word_ is a substring of lowercase other.word_. 
    *   @param other Node to compare this to. 
    */
-  bool operator%(const Node& other) const;
+  bool operator%(const Node& other) const {
+    return isInfix(getWord(), other.getWord());
+  }
+  
+  /** 
+   * Returns true if lowercase part is a substring of lowercase word, like 
+   *   the % operator does for the words of two nodes. 
+   *   @param part The string searched for. 
+   *   @param word The string searched in. 
+   */
+  static bool isInfix(std::string_view part, std::string_view word);
   
   /** 
    * Insertion operator. 
@@ -92,8 +204,18 @@ class Node {
   
   
  private:
-  std::string word_;    // stores a word from file
-  int frequency_;       // stores frequency of word in file
+  /** 
+   * 2 argument Node constructor. 
+   *   Refers to in_word, which must already be in a StringPool, and 
+   *   initializes frequency_ to frequency. 
+   *   @param in_word    A word in a StringPool. 
+   *   @param frequency  The frequency that the word arises in the file. 
+   */
+  Node(std::string_view in_word, int frequency);
+
+  const char* word_;       // first character of a word from file
+  std::uint32_t length_;   // number of characters in the word
+  int frequency_;          // stores frequency of word in file
 };
 
 
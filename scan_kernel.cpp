@@ -0,0 +1,193 @@
+#include "scan_kernel.h"
+
+//the vector levels are only built for x86, where the compiler is asked for
+//each instruction set function by function, so the rest of the program
+//still runs on processors without them
+#if defined(__x86_64__) || defined(__i386__)
+#define SCAN_KERNEL_X86
+#include <immintrin.h>   // for SSE2 and AVX2 intrinsics
+#endif
+
+//word bytes are the ones the old \W|\s|\d regex kept: A-Z, a-z and
+//underscore. Spaces are the bytes isspace accepts in the "C" locale.
+constexpr std::array<ScanKernel::CharClass, 256>
+ScanKernel::buildClassTable() {
+  std::array<CharClass, 256> table{};
+  for (int c = 'A'; c <= 'Z'; ++c)
+    table[c] = kWord;
+  for (int c = 'a'; c <= 'z'; ++c)
+    table[c] = kWord;
+  table['_'] = kWord;
+  table[' '] = kSpace;
+  table['\t'] = kSpace;
+  table['\n'] = kSpace;
+  table['\v'] = kSpace;
+  table['\f'] = kSpace;
+  table['\r'] = kSpace;
+  return table;
+}
+
+const std::array<ScanKernel::CharClass, 256> ScanKernel::kClassTable =
+  ScanKernel::buildClassTable();
+
+void ScanKernel::classifyScalar(const char* block, std::uint64_t& word_mask,
+				std::uint64_t& space_mask) {
+  word_mask = 0;
+  space_mask = 0;
+  for (std::size_t i = 0; i < kBlockSize; ++i) {
+    word_mask |= static_cast<std::uint64_t>(isWordChar(block[i])) << i;
+    space_mask |= static_cast<std::uint64_t>(isSpace(block[i])) << i;
+  }
+}
+
+void ScanKernel::foldScalar(char* out, const char* in, std::size_t size) {
+  for (std::size_t i = 0; i < size; ++i)
+    out[i] = foldChar(in[i]);
+}
+
+#ifdef SCAN_KERNEL_X86
+namespace {
+
+//there are no unsigned byte comparisons below AVX-512, so a byte is checked
+//for being in [low, low + count) by shifting that range down to the bottom
+//of the signed bytes and comparing once
+
+__attribute__((target("sse2")))
+__m128i inRange16(__m128i bytes, char low, char count) {
+  __m128i shifted {_mm_add_epi8(bytes, _mm_set1_epi8(
+      static_cast<char>(-128 - low)))};
+  return _mm_cmplt_epi8(shifted, _mm_set1_epi8(static_cast<char>(-128 +
+								 count)));
+}
+
+__attribute__((target("avx2")))
+__m256i inRange32(__m256i bytes, char low, char count) {
+  __m256i shifted {_mm256_add_epi8(bytes, _mm256_set1_epi8(
+      static_cast<char>(-128 - low)))};
+  return _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(-128 + count)),
+			   shifted);
+}
+
+//a byte is a letter if setting its 0x20 bit turns it into a-z, which maps
+//A-Z onto a-z and nothing else onto a-z
+
+__attribute__((target("sse2")))
+void classifySse2(const char* block, std::uint64_t& word_mask,
+		  std::uint64_t& space_mask) {
+  word_mask = 0;
+  space_mask = 0;
+  for (std::size_t i = 0; i < ScanKernel::kBlockSize; i += 16) {
+    __m128i bytes {_mm_loadu_si128(reinterpret_cast<const __m128i*>(block +
+								     i))};
+    __m128i letter {inRange16(_mm_or_si128(bytes, _mm_set1_epi8(0x20)),
+			      'a', 26)};
+    __m128i word {_mm_or_si128(letter, _mm_cmpeq_epi8(bytes,
+						      _mm_set1_epi8('_')))};
+    __m128i space {_mm_or_si128(inRange16(bytes, '\t', 5),
+				_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')))};
+    word_mask |= static_cast<std::uint64_t>(
+	static_cast<unsigned>(_mm_movemask_epi8(word))) << i;
+    space_mask |= static_cast<std::uint64_t>(
+	static_cast<unsigned>(_mm_movemask_epi8(space))) << i;
+  }
+}
+
+__attribute__((target("sse2")))
+void foldSse2(char* out, const char* in, std::size_t size) {
+  std::size_t i {0};
+  for (; i + 16 <= size; i += 16) {
+    __m128i bytes {_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))};
+    __m128i upper {inRange16(bytes, 'A', 26)};
+    bytes = _mm_add_epi8(bytes, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), bytes);
+  }
+  for (; i < size; ++i)
+    out[i] = ScanKernel::foldChar(in[i]);
+}
+
+__attribute__((target("avx2")))
+void classifyAvx2(const char* block, std::uint64_t& word_mask,
+		  std::uint64_t& space_mask) {
+  word_mask = 0;
+  space_mask = 0;
+  for (std::size_t i = 0; i < ScanKernel::kBlockSize; i += 32) {
+    __m256i bytes {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block +
+									i))};
+    __m256i letter {inRange32(_mm256_or_si256(bytes, _mm256_set1_epi8(0x20)),
+			      'a', 26)};
+    __m256i word {_mm256_or_si256(letter, _mm256_cmpeq_epi8(
+	bytes, _mm256_set1_epi8('_')))};
+    __m256i space {_mm256_or_si256(inRange32(bytes, '\t', 5),
+				   _mm256_cmpeq_epi8(bytes,
+						     _mm256_set1_epi8(' ')))};
+    word_mask |= static_cast<std::uint64_t>(
+	static_cast<unsigned>(_mm256_movemask_epi8(word))) << i;
+    space_mask |= static_cast<std::uint64_t>(
+	static_cast<unsigned>(_mm256_movemask_epi8(space))) << i;
+  }
+}
+
+__attribute__((target("avx2")))
+void foldAvx2(char* out, const char* in, std::size_t size) {
+  std::size_t i {0};
+  for (; i + 32 <= size; i += 32) {
+    __m256i bytes {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in +
+									i))};
+    __m256i upper {inRange32(bytes, 'A', 26)};
+    bytes = _mm256_add_epi8(bytes, _mm256_and_si256(upper,
+						    _mm256_set1_epi8(0x20)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), bytes);
+  }
+  //what is left is shorter than a vector, hand it to the narrower kernel
+  foldSse2(out + i, in + i, size - i);
+}
+
+}  // namespace
+#endif
+
+ScanKernel::ScanKernel(Level level)
+  : level_{kScalar}, classify_{classifyScalar}, fold_{foldScalar} {
+  while (!isSupported(level))
+    level = static_cast<Level>(level - 1);
+  level_ = level;
+#ifdef SCAN_KERNEL_X86
+  if (level_ == kSse2) {
+    classify_ = classifySse2;
+    fold_ = foldSse2;
+  }
+  else if (level_ == kAvx2) {
+    classify_ = classifyAvx2;
+    fold_ = foldAvx2;
+  }
+#endif
+}
+
+ScanKernel ScanKernel::best() {
+  return ScanKernel(kAvx2);
+}
+
+bool ScanKernel::isSupported(Level level) {
+  switch (level) {
+  case kScalar:
+    return true;
+#ifdef SCAN_KERNEL_X86
+  case kSse2:
+    return __builtin_cpu_supports("sse2");
+  case kAvx2:
+    return __builtin_cpu_supports("avx2");
+#endif
+  default:
+    return false;
+  }
+}
+
+const char* ScanKernel::getName() const {
+  switch (level_) {
+  case kSse2:
+    return "sse2";
+  case kAvx2:
+    return "avx2";
+  default:
+    return "scalar";
+  }
+}
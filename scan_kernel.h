@@ -0,0 +1,133 @@
+/** 
+ *
+ */
+#ifndef SCAN_KERNEL_H_
+#define SCAN_KERNEL_H_
+
+#include <array>     // for array
+#include <cstddef>   // for size_t
+#include <cstdint>   // for uint64_t
+
+/** 
+ * ScanKernel classifies the bytes of a buffer the way Tokenizer needs them:
+ *   word bytes (A-Z, a-z and underscore), whitespace, and everything else,
+ *   which is stripped out of words. It works on blocks of kBlockSize bytes
+ *   and hands back one bit per byte, so the tokenizer can find where words
+ *   start and end by counting zero bits instead of looking at every byte.
+ *   It also folds the ASCII letters of a word to lowercase. Each level does
+ *   the same work with wider instructions: kScalar a byte at a time through
+ *   a lookup table, kSse2 16 bytes and kAvx2 32 bytes at a time. The levels
+ *   a processor can't run are found at run time and fall back to the best
+ *   one it can, so a single binary runs everywhere.
+ */
+class ScanKernel {
+ public:
+  // ways of doing the work, from slowest to fastest
+  enum Level {kScalar, kSse2, kAvx2};
+
+  // number of bytes classified at once by classifyBlock
+  static const std::size_t kBlockSize = 64;
+
+  /** 
+   * ScanKernel 1-arg constructor.
+   *   Uses level if the processor supports it, and otherwise the best level
+   *   below it that it does.
+   *   @param level The level wanted.
+   */
+  explicit ScanKernel(Level level);
+
+  /** 
+   * Returns a kernel using the best level the processor supports.
+   */
+  static ScanKernel best();
+
+  /** 
+   * Returns true if the processor can run level.
+   *   @param level The level to be checked.
+   */
+  static bool isSupported(Level level);
+
+  /** 
+   * Returns the level the kernel actually uses.
+   */
+  Level getLevel() const {return level_;}
+
+  /** 
+   * Returns the name of the level the kernel uses, "scalar", "sse2" or
+   *   "avx2".
+   */
+  const char* getName() const;
+
+  /** 
+   * Sets bit i of word_mask if byte i of block is a word byte, and bit i of
+   *   space_mask if it is whitespace.
+   *   @param block The kBlockSize bytes to be classified.
+   *   @param word_mask Set to the word bytes of block.
+   *   @param space_mask Set to the whitespace bytes of block.
+   */
+  void classifyBlock(const char* block, std::uint64_t& word_mask,
+		     std::uint64_t& space_mask) const {
+    classify_(block, word_mask, space_mask);
+  }
+
+  /** 
+   * Copies size bytes from in to out with A-Z turned into a-z. in and out
+   *   may be the same buffer.
+   *   @param out Where the folded bytes are written.
+   *   @param in The bytes to be folded.
+   *   @param size The number of bytes.
+   */
+  void foldCase(char* out, const char* in, std::size_t size) const {
+    fold_(out, in, size);
+  }
+
+  /** 
+   * Returns true if c is kept as part of a word.
+   *   @param c The byte to be classified.
+   */
+  static bool isWordChar(char c) {
+    return kClassTable[static_cast<unsigned char>(c)] == kWord;
+  }
+
+  /** 
+   * Returns true if c separates words.
+   *   @param c The byte to be classified.
+   */
+  static bool isSpace(char c) {
+    return kClassTable[static_cast<unsigned char>(c)] == kSpace;
+  }
+
+  /** 
+   * Returns c with A-Z turned into a-z, and any other byte unchanged.
+   *   @param c The byte to be folded.
+   */
+  static char foldChar(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+  }
+
+ private:
+  // Classes a byte can fall into. kStrip bytes are dropped from words.
+  enum CharClass : unsigned char {kStrip, kWord, kSpace};
+
+  // Maps every byte value to its CharClass.
+  static const std::array<CharClass, 256> kClassTable;
+
+  /** 
+   * Builds kClassTable at compile time.
+   */
+  static constexpr std::array<CharClass, 256> buildClassTable();
+
+  /** 
+   * The byte at a time versions of classifyBlock and foldCase, which every
+   *   processor can run.
+   */
+  static void classifyScalar(const char* block, std::uint64_t& word_mask,
+			     std::uint64_t& space_mask);
+  static void foldScalar(char* out, const char* in, std::size_t size);
+
+  Level level_;   // the level in use, after falling back
+  void (*classify_)(const char*, std::uint64_t&, std::uint64_t&);
+  void (*fold_)(char*, const char*, std::size_t);
+};
+
+#endif //SCAN_KERNEL_H_
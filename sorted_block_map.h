@@ -0,0 +1,365 @@
+/** 
+ *
+ */
+#ifndef SORTED_BLOCK_MAP_H_
+#define SORTED_BLOCK_MAP_H_
+
+#include <algorithm>     // for lower_bound, partial_sort, upper_bound
+#include <cstddef>       // for size_t
+#include <iostream>      // for cout
+#include <iterator>      // for back_inserter
+#include <utility>       // for move
+#include <vector>        // for vector
+
+#include "tree_stats.h"
+
+
+/** 
+ * SortedBlockMap keeps its elements sorted in a sequence of blocks of at 
+ *   most MAX_BLOCK_SIZE elements each, like the leaves of a B-tree with a 
+ *   single level above them, and has the counting interface of SplayTree. 
+ *   A search does a binary search over the first element of every block 
+ *   and then one inside the block it picked, touching two arrays instead 
+ *   of a path of vertices. A block that overflows is split in half. Since 
+ *   the blocks are in order one after another, in order and prefix visits 
+ *   scan consecutive memory, which makes the map a good fit for range 
+ *   queries. References to elements are invalidated when an element is 
+ *   added. There is no splaying, so the splay count and TreeStats are 
+ *   always 0. 
+ */
+template <typename T>
+class SortedBlockMap {
+ public:
+  /** 
+   * SortedBlockMap no-arg constructor. 
+   *   Starts out with no blocks. 
+   */
+  SortedBlockMap() : node_count_{0} {}
+
+  /** 
+   * Finds the element equal to key, or inserts T(key) if there is none, 
+   *   and returns it. If the element was already present, its frequency 
+   *   counter is incremented. 
+   *   @param key The key to be counted. 
+   */
+  template <typename K>
+  const T& upsert(const K& key);
+
+  /** 
+   * Like upsert, but inserts a copy of element_in if it is not present and 
+   *   otherwise adds its frequency to the element already in the map. 
+   *   @param element_in The element whose count is to be added. 
+   */
+  const T& accumulate(const T& element_in);
+
+  /** 
+   * Returns the element equal to key, or nullptr if there is none. 
+   *   @param key The key to be looked up. 
+   */
+  template <typename K>
+  const T* lookup(const K& key) const;
+
+  /** 
+   * Returns true if there are no elements in the map. 
+   */
+  bool isEmpty() const {return node_count_ == 0;}
+
+  /** 
+   * Returns the number of elements in the map. 
+   */
+  int getNodeCount() const {return node_count_;}
+
+  /** 
+   * Returns 0, nothing is ever splayed. 
+   */
+  int getSplayCount() const {return 0;}
+
+  /** 
+   * Returns empty TreeStats, nothing is counted. 
+   */
+  TreeStats getStats() const {return TreeStats();}
+
+  /** 
+   * Prints every element in sorted order to the std output stream. 
+   */
+  void printTree() {
+    visitInOrder([](const T& element) {std::cout << element << "\n";});
+  }
+
+  /** 
+   * Inserts the smallest element into the std output stream, which is where 
+   *   every search starts from. 
+   */
+  void printRoot() const {
+    if (!blocks_.empty())
+      std::cout << blocks_.front().front();
+  }
+
+  /** 
+   * Calls visit on each element x of the map for which x.hasPrefix(prefix) 
+   *   is true, in sorted order. The search seeks to the first element that 
+   *   is not less than prefix and scans forward, across blocks, until an 
+   *   element does not start with it. 
+   *   @param prefix What every element visited must start with. 
+   *   @param visit A function object taking a const T&. 
+   */
+  template <typename K, typename Visitor>
+  void findAll(const K& prefix, Visitor visit) const;
+
+  /** 
+   * Calls visit on the k most frequent elements x of the map for which 
+   *   x.hasPrefix(prefix) is true, most frequent first and in sorted order 
+   *   among equal frequencies. Every match is looked at and the matches are 
+   *   ranked. 
+   *   @param prefix What every element visited must start with. 
+   *   @param k The number of elements wanted. 
+   *   @param visit A function object taking a const T&. 
+   */
+  template <typename K, typename Visitor>
+  void findTop(const K& prefix, int k, Visitor visit) const;
+
+  /** 
+   * Calls visit on each element of the map in sorted order. 
+   *   @param visit A function object taking a const T&. 
+   */
+  template <typename Visitor>
+  void visitInOrder(Visitor visit) const {
+    for (const std::vector<T>& block : blocks_)
+      for (const T& element : block)
+	visit(element);
+  }
+
+  /** 
+   * Replaces the contents of the map with count elements, where element i 
+   *   is make(i). The elements must be produced in sorted order. Every 
+   *   block but the last is filled to MAX_BLOCK_SIZE / 2, so that the 
+   *   first insertions afterwards do not split them. 
+   *   @param count The number of elements in the new map. 
+   *   @param make A function object taking a std::size_t and returning a T. 
+   */
+  template <typename Make>
+  void buildFromSorted(std::size_t count, Make make);
+
+  /** 
+   * Merges the elements of other into this map in time linear in the size 
+   *   of both. An element found in both keeps the one in this map with the 
+   *   frequency of the other one added to it, and an element only in other 
+   *   is added as adopt(element). The map is then rebuilt with 
+   *   buildFromSorted. other is not modified. 
+   *   @param other The map whose elements are to be merged in. 
+   *   @param adopt A function object taking a const T& and returning the T 
+   *     to be stored for it. 
+   */
+  template <typename Adopt>
+  void unite(const SortedBlockMap& other, Adopt adopt);
+
+  /** 
+   * Merges the elements of other into this map as above, copying elements 
+   *   that are only in other as they are. 
+   *   @param other The map whose elements are to be merged in. 
+   */
+  void unite(const SortedBlockMap& other) {
+    unite(other, [](const T& element) {return element;});
+  }
+
+ private:
+  static constexpr std::size_t MAX_BLOCK_SIZE = 128;
+
+  /** 
+   * Returns the index of the block key belongs in: the last block whose 
+   *   first element is not greater than key, or 0 if key is smaller than 
+   *   every element. There must be at least one block. 
+   *   @param key The key to be searched for. 
+   */
+  template <typename K>
+  std::size_t findBlock(const K& key) const;
+
+  /** 
+   * Returns the element equal to key, inserting make() where it belongs if 
+   *   there is none, and calls found with the element if it was there. 
+   *   @param key The key to be searched for. 
+   *   @param make A function object returning the T to be inserted. 
+   *   @param found A function object taking the T& that was found. 
+   */
+  template <typename K, typename Make, typename Found>
+  T& findOrInsert(const K& key, Make make, Found found);
+
+  std::vector<std::vector<T>> blocks_;  // the elements, in sorted order
+  std::vector<T> firsts_;  // copy of the first element of each block
+  int node_count_;         // number of elements in every block
+};
+
+
+// Function definitions below
+
+template <typename T>
+template <typename K>
+const T& SortedBlockMap<T>::upsert(const K& key) {
+  return findOrInsert(key, [&key]() {return T(key);},
+		      [](T& element) {element.incrementFrequency();});
+}
+
+template <typename T>
+const T& SortedBlockMap<T>::accumulate(const T& element_in) {
+  return findOrInsert(element_in, [&element_in]() {return element_in;},
+		      [&element_in](T& element) {
+			element.addFrequency(element_in.getFrequency());
+		      });
+}
+
+template <typename T>
+template <typename K>
+std::size_t SortedBlockMap<T>::findBlock(const K& key) const {
+  auto it = std::upper_bound(firsts_.begin(), firsts_.end(), key,
+			     [](const K& k, const T& first) {
+			       return k < first;
+			     });
+  return it == firsts_.begin() ? 0 : it - firsts_.begin() - 1;
+}
+
+template <typename T>
+template <typename K>
+const T* SortedBlockMap<T>::lookup(const K& key) const {
+  if (blocks_.empty())
+    return nullptr;
+  const std::vector<T>& block {blocks_[findBlock(key)]};
+  auto it = std::lower_bound(block.begin(), block.end(), key,
+			     [](const T& element, const K& k) {
+			       return element < k;
+			     });
+  if (it == block.end() || key < *it)
+    return nullptr;
+  return &*it;
+}
+
+template <typename T>
+template <typename K, typename Make, typename Found>
+T& SortedBlockMap<T>::findOrInsert(const K& key, Make make, Found found) {
+  if (blocks_.empty()) {
+    blocks_.emplace_back();
+    blocks_.back().reserve(MAX_BLOCK_SIZE + 1);
+    firsts_.emplace_back();
+  }
+  std::size_t block_index {findBlock(key)};
+  std::vector<T>& block {blocks_[block_index]};
+  auto it = std::lower_bound(block.begin(), block.end(), key,
+			     [](const T& element, const K& k) {
+			       return element < k;
+			     });
+  if (it != block.end() && !(key < *it)) {
+    found(*it);
+    return *it;
+  }
+
+  std::size_t position = it - block.begin();
+  block.insert(it, make());
+  ++node_count_;
+  if (position == 0)
+    firsts_[block_index] = block.front();
+  if (block.size() <= MAX_BLOCK_SIZE)
+    return block[position];
+
+  //move the upper half into a block of its own right after this one
+  std::vector<T> upper;
+  upper.reserve(MAX_BLOCK_SIZE + 1);
+  std::size_t half {block.size() / 2};
+  std::move(block.begin() + half, block.end(), std::back_inserter(upper));
+  block.resize(half);
+  T upper_first {upper.front()};
+  blocks_.insert(blocks_.begin() + block_index + 1, std::move(upper));
+  firsts_.insert(firsts_.begin() + block_index + 1, upper_first);
+  if (position < half)
+    return blocks_[block_index][position];
+  return blocks_[block_index + 1][position - half];
+}
+
+template <typename T>
+template <typename K, typename Visitor>
+void SortedBlockMap<T>::findAll(const K& prefix, Visitor visit) const {
+  if (blocks_.empty())
+    return;
+  //elements starting with prefix are contiguous from the first one >= prefix
+  for (std::size_t b = findBlock(prefix); b < blocks_.size(); ++b) {
+    const std::vector<T>& block {blocks_[b]};
+    auto it = std::lower_bound(block.begin(), block.end(), prefix,
+			       [](const T& element, const K& k) {
+				 return element < k;
+			       });
+    for (; it != block.end(); ++it) {
+      if (!it->hasPrefix(prefix))
+	return;
+      visit(*it);
+    }
+  }
+}
+
+template <typename T>
+template <typename Make>
+void SortedBlockMap<T>::buildFromSorted(std::size_t count, Make make) {
+  blocks_.clear();
+  firsts_.clear();
+  node_count_ = static_cast<int>(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    if (blocks_.empty() || blocks_.back().size() == MAX_BLOCK_SIZE / 2) {
+      blocks_.emplace_back();
+      blocks_.back().reserve(MAX_BLOCK_SIZE + 1);
+    }
+    blocks_.back().push_back(make(i));
+    if (blocks_.back().size() == 1)
+      firsts_.push_back(blocks_.back().front());
+  }
+}
+
+template <typename T>
+template <typename Adopt>
+void SortedBlockMap<T>::unite(const SortedBlockMap& other, Adopt adopt) {
+  if (this == &other)
+    return;
+
+  //walk both maps in order side by side, like a merge of sorted arrays
+  std::vector<T> merged;
+  merged.reserve(node_count_ + other.node_count_);
+  std::vector<const T*> mine;
+  std::vector<const T*> theirs;
+  mine.reserve(node_count_);
+  theirs.reserve(other.node_count_);
+  visitInOrder([&mine](const T& element) {mine.push_back(&element);});
+  other.visitInOrder([&theirs](const T& element) {
+      theirs.push_back(&element);
+    });
+  std::size_t i {0};
+  std::size_t j {0};
+  while (i < mine.size() || j < theirs.size()) {
+    if (j == theirs.size() || (i < mine.size() && *mine[i] < *theirs[j]))
+      merged.push_back(*mine[i++]);
+    else if (i == mine.size() || *theirs[j] < *mine[i])
+      merged.push_back(adopt(*theirs[j++]));
+    else {
+      merged.push_back(*mine[i++]);
+      merged.back().addFrequency(theirs[j++]->getFrequency());
+    }
+  }
+  buildFromSorted(merged.size(), [&merged](std::size_t k) {
+      return std::move(merged[k]);
+    });
+}
+
+template <typename T>
+template <typename K, typename Visitor>
+void SortedBlockMap<T>::findTop(const K& prefix, int k, Visitor visit) const {
+  std::vector<const T*> matches;
+  findAll(prefix, [&matches](const T& element) {matches.push_back(&element);});
+  auto more_frequent = [](const T* a, const T* b) {
+    if (a->getFrequency() != b->getFrequency())
+      return a->getFrequency() > b->getFrequency();
+    return *a < *b;
+  };
+  std::size_t count {std::min(matches.size(),
+			      static_cast<std::size_t>(std::max(k, 0)))};
+  std::partial_sort(matches.begin(), matches.begin() + count, matches.end(),
+		    more_frequent);
+  for (std::size_t i = 0; i < count; ++i)
+    visit(*matches[i]);
+}
+
+#endif //  SORTED_BLOCK_MAP_H_
@@ -4,7 +4,16 @@
 #ifndef SPLAY_TREE_H_
 #define SPLAY_TREE_H_
 
-#include <iostream>   // for cout, cerr
+#include <algorithm>     // for max, push_heap, pop_heap
+#include <cstddef>       // for size_t
+#include <cstdint>       // for uint64_t
+#include <iostream>      // for cout, cerr
+#include <type_traits>   // for is_trivially_destructible
+#include <utility>       // for forward, move
+#include <vector>        // for vector
+
+#include "tree_stats.h"
+#include "vertex_pool.h"
 
 
 /** 
@@ -14,11 +23,36 @@
  *   provides a variety of functions for accessing, modifying and printing
  *   the contents of the tree. The type of the template parameter is assumed to
  *   have the less-than "<" relational operator defined, as it is utilized in 
- *   this implementation.  
+ *   this implementation. Vertices are allocated through the VertexPool 
+ *   policy, SlabPool by default, which carves them out of large slabs and 
+ *   frees them all at once when the tree is cleared. When built with 
+ *   WFC_STATS defined, each tree also keeps TreeStats on its rotations, 
+ *   comparisons and search depths. Every traversal follows parent links 
+ *   instead of recursing, so a tree left as one long path, as inserting in
+ *   sorted order does, can still be printed, copied and cleared. With 
+ *   setDepthFactor the depth a search may reach can also be bounded, and 
+ *   with setSplayStrategy searches can leave some of the vertices they 
+ *   reach where they are instead of splaying every one of them. Every 
+ *   vertex also keeps the highest frequency found in its subtree, so 
+ *   findTop can pick out the most frequent elements with a prefix without
+ *   visiting all of them; T must have getFrequency, and frequencies are 
+ *   only changed through the tree, which never lowers them. 
  */
-template <typename T>
+template <typename T, template <typename> class VertexPool = SlabPool>
 class SplayTree {
  public:
+  /** 
+   * SplayStrategy selects which of the vertices reached by insert, upsert 
+   *   and accumulate are splayed to the root. kAlways splays every one of 
+   *   them, as a classic splay tree does. kEveryKth only splays on every 
+   *   k-th of those accesses, kDeeperThan only splays vertices found deeper
+   *   than a given depth, so words already near the root are left alone, 
+   *   and kRandom splays each access with a given probability. Vertices 
+   *   that are not splayed stay where they are, so the tree is not 
+   *   modified by the search at all. 
+   */
+  enum class SplayStrategy {kAlways, kEveryKth, kDeeperThan, kRandom};
+
   /** 
    * SplayTree no-arg constructor. 
    *   Sets root to nullptr, and counter values to 0.
@@ -40,25 +74,68 @@ class SplayTree {
   ~SplayTree();
   
   /** 
-   * Inserts the element into the splay tree. Splays the tree afterwards to 
-   *   make the node containing element_in the root. Increments node_count also.
+   * Inserts a copy of the element into the splay tree. Splays the tree 
+   *   afterwards to make the node containing element_in the root, unless 
+   *   the splay strategy skips it. Increments node_count also.
    *   @param element_in The object to be inserted into the splay tree. 
    */
-  void insert(T element_in);
+  void insert(const T& element_in) {insert(T(element_in));}
+
+  /** 
+   * Moves the element into the splay tree, otherwise like insert above. 
+   *   @param element_in The object to be moved into the splay tree. 
+   */
+  void insert(T&& element_in);
+  
+  /** 
+   * Finds the vertex whose element is equal to key, or inserts a new vertex 
+   *   holding T(key) if there is none, in a single descent from the root. 
+   *   The vertex is splayed to the root afterwards, unless the splay 
+   *   strategy skips it. If the element was already present, its frequency 
+   *   counter is incremented. Returns a reference to the element held in 
+   *   the tree, which stays valid until it is removed, and is const so that
+   *   its frequency is only changed through the tree. Key may be T itself 
+   *   or any type that can be compared with T in both directions using "<",
+   *   so the caller only builds a T when a new element is actually 
+   *   inserted. 
+   *   @param key The object to be looked up or inserted. 
+   */
+  template <typename K>
+  const T& upsert(const K& key);
+  
+  /** 
+   * Inserts a copy of element_in if no vertex holds an equal element, or 
+   *   adds the frequency of element_in to the element that is already there.
+   *   Used to fold the counts of one tree into another. The vertex is 
+   *   splayed to the root afterwards like in upsert. Returns a reference to
+   *   the element held in the tree. 
+   *   @param element_in The object whose count is to be added to the tree. 
+   */
+  const T& accumulate(const T& element_in);
   
   /** 
    * Removes the first vertex discovered that contains element_in from the tree.
    *   Decrements node_count as well. 
    *   @param element The object to be removed from the splay tree. 
    */
-  void remove(T element);
+  void remove(const T& element);
   
   /** 
    * Returns true if there is a vertex in the tree that contains element. 
    *   @param element The object to be searched for in the tree. 
    */
-  bool contains(T element) {return findVertex(element) != nullptr;}
-  
+  bool contains(const T& element) {return findVertex(element) != nullptr;}
+
+  /** 
+   * Returns the element equal to key, or nullptr if there is none. Unlike 
+   *   contains, the tree is not splayed or otherwise modified, so a lookup 
+   *   does not move the element closer to the root. 
+   *   @param key The object to be searched for, T or anything comparable 
+   *     with T in both directions. 
+   */
+  template <typename K>
+  const T* lookup(const K& key) const;
+
   /** 
    * Returns true if there are no nodes in the tree. 
    */
@@ -71,21 +148,69 @@ class SplayTree {
   void printTree();
   
   /** 
-   * Returns the number of times that the splay function has been invoked. 
+   * Returns the number of splay steps performed, where a zig-zig or zig-zag
+   *   step counts once even though it makes two rotations. 
    */
   int getSplayCount() const  {return splay_counter_;}
+  
+  /** 
+   * Returns the rotation, comparison and depth counts of the tree, which 
+   *   are all 0 unless the program is built with WFC_STATS defined. 
+   */
+  TreeStats getStats() const {
+#ifdef WFC_STATS
+    return stats_;
+#else
+    return TreeStats();
+#endif
+  }
 
   /** 
    * Increments the frequency counter of the object contained in the root 
    *   vertex. Utilized by the Node class for this project. 
    */
-  void incrementValue()  {(root_->element).incrementFrequency();}
+  void incrementValue()  {
+    (root_->element).incrementFrequency();
+    raiseMaxFrequency(root_);
+  }
   
   /** 
    * Returns the number of vertices in the splay tree. 
    */
   int getNodeCount() const  {return node_count_;}
   
+  /** 
+   * Returns the number of edges on the longest path from the root down to a
+   *   vertex, or -1 for an empty tree. Every vertex is visited. 
+   */
+  int getHeight() const;
+  
+  /** 
+   * Bounds the depth a search may reach when factor is positive, and turns
+   *   the bound off when it is 0, which is the default. While it is on, a 
+   *   search that ends deeper than factor times the number of bits in the 
+   *   node count rebuilds the smallest subtree around the vertex it found 
+   *   that brings the vertex back within the bound, perfectly balanced, 
+   *   before splaying it. Paths built up by sorted or adversarial input are 
+   *   then only walked once. 
+   *   @param factor The depth allowed per bit of the node count, 0 for no 
+   *     bound. 
+   */
+  void setDepthFactor(int factor) {depth_factor_ = factor;}
+  
+  /** 
+   * Sets which accesses splay the vertex they reach, kAlways by default. 
+   *   Explicit calls to splay, and the splaying done by remove, split and 
+   *   join, always happen. Skipping splays saves the rotations, and the 
+   *   writes to the vertices they relink, of accesses to words that are 
+   *   already near the root, at the cost of more depth for the others; 
+   *   setDepthFactor still bounds how deep a search may go. 
+   *   @param strategy Which accesses are splayed. 
+   *   @param parameter k for kEveryKth, the depth for kDeeperThan, and the 
+   *     probability for kRandom, from 0 to 1. Ignored for kAlways. 
+   */
+  void setSplayStrategy(SplayStrategy strategy, double parameter = 0);
+  
   /** 
    * Assignment operator. 
    *   Deletes the current contents of the tree, and makes a deep copy 
@@ -101,11 +226,101 @@ class SplayTree {
   void printRoot() const;
   
   /** 
-   * Inserts each element x from the tree into the std output stream 
-   *   that satisfies element_in % x. Assumes the modulus operator "%" is 
-   *   defined for the template parameter type. 
+   * Calls visit on each element x of the tree for which x.hasPrefix(prefix)
+   *   is true, in sorted order. Only the range of matching elements is 
+   *   walked: the search seeks to the first element that is not less than 
+   *   prefix and stops at the first one that does not start with it, so a 
+   *   query costs the depth of the tree plus the number of matches. The 
+   *   tree is not splayed or otherwise modified. 
+   *   @param prefix What every element visited must start with. 
+   *   @param visit A function object taking a const T&. 
+   */
+  template <typename K, typename Visitor>
+  void findAll(const K& prefix, Visitor visit) const;
+  
+  /** 
+   * Calls visit on the k most frequent elements x of the tree for which 
+   *   x.hasPrefix(prefix) is true, most frequent first and in sorted order 
+   *   among equal frequencies. The subtrees holding only matches are found 
+   *   along the two paths that bound them, then searched best first by 
+   *   their highest frequency, so only the vertices on the way down to each 
+   *   element visited are looked at, not every match. The tree is not 
+   *   splayed or otherwise modified. 
+   *   @param prefix What every element visited must start with. 
+   *   @param k The number of elements wanted. 
+   *   @param visit A function object taking a const T&. 
+   */
+  template <typename K, typename Visitor>
+  void findTop(const K& prefix, int k, Visitor visit) const;
+  
+  /** 
+   * Calls visit on each element of the tree in sorted order. The tree is 
+   *   not splayed or otherwise modified. 
+   *   @param visit A function object taking a const T&. 
+   */
+  template <typename Visitor>
+  void visitInOrder(Visitor visit) const {
+    walkInOrder(root_, [&visit](const Vertex* vertex) {
+	visit(vertex->element);
+      });
+  }
+  
+  /** 
+   * Replaces the contents of the tree with count elements, where element i 
+   *   is make(i). The elements must be produced in sorted order. The tree is
+   *   built perfectly balanced in linear time, without any comparisons or 
+   *   splaying, and its vertices come out of a single slab. 
+   *   @param count The number of elements in the new tree. 
+   *   @param make A function object taking a std::size_t and returning a T.
+   */
+  template <typename Make>
+  void buildFromSorted(std::size_t count, Make make);
+  
+  /** 
+   * Moves every element that is not less than key into greater, replacing 
+   *   whatever greater held, and keeps the smaller ones. The vertex where 
+   *   the search for key ended is splayed first, so the cut is a single 
+   *   link at the root. The vertices are handed over without being copied, 
+   *   greater shares the slabs they live in. Counting the elements that 
+   *   moved costs as much as the smaller of the two halves. 
+   *   @param key Where the tree is cut. 
+   *   @param greater Receives the elements not less than key. 
+   */
+  void split(const T& key, SplayTree& greater);
+  
+  /** 
+   * Moves every element of greater into this tree, leaving greater empty. 
+   *   Every element of greater must be larger than every element of this 
+   *   tree. The largest element of this tree is splayed to the root and 
+   *   greater is hung off of it as its right subtree, without copying any 
+   *   vertices. 
+   *   @param greater The tree whose elements are appended. 
+   */
+  void join(SplayTree& greater);
+  
+  /** 
+   * Merges the elements of other into this tree in time linear in the size 
+   *   of both, instead of inserting them one by one. Both trees are walked 
+   *   in order side by side; an element found in both keeps the one in this
+   *   tree with the frequency of the other one added to it, and an element 
+   *   only in other is added as adopt(element). The tree is then rebuilt 
+   *   perfectly balanced with buildFromSorted. other is not modified. 
+   *   @param other The tree whose elements are to be merged in. 
+   *   @param adopt A function object taking a const T& and returning the T 
+   *     to be stored for it, for elements that refer to storage owned by 
+   *     other's owner. 
    */
-  void findAll(const T& element_in);
+  template <typename Adopt>
+  void unite(const SplayTree& other, Adopt adopt);
+  
+  /** 
+   * Merges the elements of other into this tree as above, copying elements 
+   *   that are only in other as they are. 
+   *   @param other The tree whose elements are to be merged in. 
+   */
+  void unite(const SplayTree& other) {
+    unite(other, [](const T& element) {return element;});
+  }
   
   /** 
    * Performs the splay operation on the vertex containing the input parameter. 
@@ -115,7 +330,7 @@ class SplayTree {
    *   @param element_in The object whose containing vertex is to be set as the 
    *     root of the tree. 
    */
-  void splay(T element_in);
+  void splay(const T& element_in);
 
  private:
   /** 
@@ -129,6 +344,7 @@ class SplayTree {
     Vertex* left_child;
     Vertex* right_child;
     Vertex* parent;
+    int max_frequency;   // highest frequency of an element in the subtree
     
     /** 
      * Vertex default constructor. 
@@ -137,23 +353,29 @@ class SplayTree {
   Vertex() : element{},
       left_child{nullptr},
       right_child{nullptr},
-      parent{nullptr} {}
+      parent{nullptr},
+      max_frequency{0} {}
     
     /** 
      * Vertex 4 arg constructor.
      *   Initializes each of the member variables to the values in their 
-     *   corresponding input parameters. 
-     *   @param in_element Copies in_element to the member variable element.
+     *   corresponding input parameters. The subtree maximum starts out as 
+     *   the frequency of the element, and is brought up to date by the tree
+     *   once the children are linked. 
+     *   @param in_element Copied or moved, depending on how it is passed, 
+     *     to the member variable element.
      *   @param left_vertex Contains the location of the vertex's left child.
      *   @param right_vertex Contains the location of the vertex's right child.
      *   @param parent_vertex Contains the location of the vertex's parent. 
      */
-  Vertex(const T& in_element,
+  template <typename U>
+  Vertex(U&& in_element,
 	 Vertex* left_vertex,
 	 Vertex* right_vertex,
 	 Vertex* parent_vertex) :
-    element{in_element}, left_child{left_vertex},
-      right_child{right_vertex}, parent{parent_vertex} {}
+    element(std::forward<U>(in_element)), left_child{left_vertex},
+      right_child{right_vertex}, parent{parent_vertex},
+      max_frequency{element.getFrequency()} {}
   };
   
   /** 
@@ -163,6 +385,13 @@ class SplayTree {
    */
   void clear(Vertex* node);
 
+  /** 
+   * Deletes every vertex in the tree and gives the memory back to the pool 
+   *   in bulk. The vertices are only visited one by one when their elements 
+   *   need destructors run, or when the pool cannot release in bulk. 
+   */
+  void clearAll();
+
   /** 
    * Rotates node to the left by making the right child of node the parent of  
    *   node. Preserves the order of the tree. 
@@ -192,94 +421,219 @@ class SplayTree {
   T findMax(Vertex* node);
   
   /** 
-   * Prints the object contained by node as well as each of node's descendants 
-   *   in order. 
-   *   @param node The vertex whose contents and whose descendant's contents 
-   *     are to be printed. 
+   * Performs the splay operation on splay_vertex, rotating it up until it 
+   *   becomes the root of the tree. 
+   *   @param splay_vertex The vertex to be set as the root of the tree. 
    */
-  void printTree(Vertex* node);
+  void splay(Vertex* splay_vertex);
   
   /** 
-   * Inserts each element x from node and its descendants
-   *   into the std output stream that satisfies element_in % x. 
-   *   Assumes the modulus operator "%" is defined for the template 
-   *   parameter type. 
-   *   @param element_in The object to compare the vertex's objects to w/ %.
-   *   @param node The vertex whose descendants are to be checked. 
+   * Searches the tree for the vertex whose element is equal to key in a 
+   *   single descent, creating a vertex holding T(key) where the search 
+   *   ended if there is none, then splays that vertex to the root and 
+   *   returns it. 
+   *   @param key The object to be searched for in the tree. 
+   *   @param found Set to true if the vertex was already in the tree. 
    */
-  void findAll(const T& element_in, Vertex* node);
+  template <typename K>
+  Vertex* findOrInsert(const K& key, bool& found);
   
   /** 
-   * Makes a new vertex and copies the contents of the old vertex to it. 
-   *   @param old The vertex whose contents are to be copied. 
+   * Calls visit on node and on each of node's descendants in order, passing
+   *   the vertices themselves. The walk climbs back up through parent links
+   *   rather than recursing or keeping a stack, so it takes no memory 
+   *   however deep the subtree is. visit may change the links of a vertex 
+   *   only after the walk is over. 
+   *   @param node The vertex whose subtree is to be visited. 
+   *   @param visit A function object taking a V*. 
    */
-  Vertex* copy(Vertex* old) {
-    if (!old)
-      return nullptr;
-    else {
-      Vertex* new_vertex{new Vertex(old->element,
-				    copy(old->left_child),
-				    copy(old->right_child))};
-      //set the parent of children to new_vertex
-      if(new_vertex->left_child)
-	new_vertex->left_child->parent = new_vertex;
-      if(new_vertex->right_child)
-	new_vertex->right_child->parent = new_vertex;
-      return new_vertex;
-    }
+  template <typename V, typename Visitor>
+  static void walkInOrder(V* node, Visitor visit);
+  
+  /** 
+   * Returns true if a search that ended depth edges below the root went 
+   *   deeper than setDepthFactor allows. 
+   *   @param depth The depth of the vertex the search ended at. 
+   */
+  bool isTooDeep(int depth) const {
+    //the limit is at least depth_factor_, so most searches stop at the first
+    return depth > depth_factor_ && depth_factor_ > 0 &&
+      depth > depth_factor_ * bitWidth(node_count_);
   }
   
+  /** 
+   * Returns true if the vertex an access reached at depth should be 
+   *   splayed, according to the splay strategy. 
+   *   @param depth The depth of the vertex the access ended at. 
+   */
+  bool shouldSplay(int depth);
+  
+  /** 
+   * Rebuilds the smallest subtree around deep_vertex whose perfectly 
+   *   balanced form holds deep_vertex within the depth bound, and returns 
+   *   the new depth of deep_vertex. The vertices are relinked in place, so 
+   *   no vertex is created or destroyed. 
+   *   @param deep_vertex The vertex a search ended at. 
+   *   @param depth The depth of deep_vertex. 
+   */
+  int rebuildAround(Vertex* deep_vertex, int depth);
+  
+  /** 
+   * Links vertices[first] up to vertices[last - 1], which are in order, 
+   *   into a perfectly balanced subtree and returns its root. 
+   *   @param vertices The vertices to be linked. 
+   *   @param first The index of the smallest vertex of the subtree. 
+   *   @param last One past the index of the largest vertex of the subtree. 
+   *   @param parent The vertex the subtree will hang off of. 
+   */
+  static Vertex* linkRange(const std::vector<Vertex*>& vertices, 
+			   std::size_t first, std::size_t last, 
+			   Vertex* parent);
+  
+  /** 
+   * Sets the subtree maximum of vertex from the frequency of its element 
+   *   and the subtree maximums of its children. 
+   *   @param vertex The vertex whose children have changed. 
+   */
+  static void updateMaxFrequency(Vertex* vertex) {
+    int max_frequency {vertex->element.getFrequency()};
+    if (vertex->left_child && vertex->left_child->max_frequency > max_frequency)
+      max_frequency = vertex->left_child->max_frequency;
+    if (vertex->right_child &&
+	vertex->right_child->max_frequency > max_frequency)
+      max_frequency = vertex->right_child->max_frequency;
+    vertex->max_frequency = max_frequency;
+  }
+  
+  /** 
+   * Brings the subtree maximums of vertex and of its ancestors up to the 
+   *   frequency of its element, after it has grown. Stops at the first 
+   *   ancestor that already has it, which is usually the parent. 
+   *   @param vertex The vertex whose frequency has grown. 
+   */
+  static void raiseMaxFrequency(Vertex* vertex) {
+    int frequency {vertex->element.getFrequency()};
+    for (; vertex && vertex->max_frequency < frequency; vertex = vertex->parent)
+      vertex->max_frequency = frequency;
+  }
+  
+  /** 
+   * Returns the number of bits needed to write count, 0 for 0. 
+   *   @param count The number to be measured. 
+   */
+  static int bitWidth(int count) {
+    int bits {0};
+    for (unsigned rest = count; rest; rest >>= 1)
+      ++bits;
+    return bits;
+  }
+  
+  /** 
+   * Builds a perfectly balanced subtree out of the elements make(first) up 
+   *   to make(last - 1) and returns its root. 
+   *   @param make A function object taking a std::size_t and returning a T.
+   *   @param first The index of the smallest element of the subtree. 
+   *   @param last One past the index of the largest element of the subtree.
+   *   @param parent The vertex the subtree will hang off of. 
+   */
+  template <typename Make>
+  Vertex* buildRange(Make& make, std::size_t first, std::size_t last,
+		     Vertex* parent);
+  
+  /** 
+   * Counts the vertices of the subtrees at first and second, which hold 
+   *   total vertices between them, and returns the count of first. Both are 
+   *   walked a vertex at a time in turn, so only the smaller one is walked 
+   *   to the end. 
+   *   @param first The subtree whose size is wanted. 
+   *   @param second The rest of the vertices. 
+   *   @param total The number of vertices in both subtrees. 
+   */
+  static int countFirst(const Vertex* first, const Vertex* second, int total);
+  
+  /** 
+   * Makes a copy of the old vertex and of each of its descendants, linked 
+   *   the same way, and returns the copy of old. 
+   *   @param old The vertex whose subtree is to be copied. 
+   */
+  Vertex* copy(const Vertex* old);
+  
   /** 
    * Searches the tree for a vertex containing element_in. If a vertex is 
    *   found, a pointer to the vertex is returned. If no vertex is found, 
    *   nullptr is returned. 
    *   @param element_in The object to be searched for in the tree. 
    */
-  Vertex* findVertex(T element_in) {
+  Vertex* findVertex(const T& element_in) {
     Vertex* temp_vertex = root_;
+    int depth {0};
     while(temp_vertex && !(temp_vertex->element == element_in)) {
       if(element_in < temp_vertex->element)
 	temp_vertex = temp_vertex->left_child;
       else 
 	temp_vertex = temp_vertex->right_child;
+      ++depth;
     }
+    //an == and a < for each vertex passed, and the last == if found
+    WFC_STAT(long comparisons {2L * depth + 1});
+    if (temp_vertex && isTooDeep(depth))
+      depth = rebuildAround(temp_vertex, depth);
+    WFC_STAT(if (temp_vertex) stats_.recordAccess(depth, comparisons));
     return temp_vertex;    
   }
 
+  VertexPool<Vertex> pool_;  // allocates and frees the vertices
   Vertex* root_;      // holds the root vertex for the tree
   int splay_counter_; // counter for the number of splays performed on tree
   int node_count_;    // holds the number of vertices in the tree
+  int depth_factor_;  // depth allowed per bit of node_count_, 0 for any
+  SplayStrategy splay_strategy_;  // which accesses are splayed
+  int splay_parameter_;           // k of kEveryKth, depth of kDeeperThan
+  int accesses_to_splay_;         // accesses left until kEveryKth splays
+  std::uint64_t splay_threshold_; // kRandom splays below this, out of 2^64
+  std::uint64_t random_state_;    // xorshift state drawn from by kRandom
+#ifdef WFC_STATS
+  TreeStats stats_;   // rotations, comparisons and depths, when enabled
+#endif
 };
 
 
 // Function definitions below
 // TODO: Rearrange definitions to be in the same order as declarations
 
-template <typename T>
-SplayTree<T>::SplayTree() : root_{nullptr}, splay_counter_{0}, node_count_{0} {}
+template <typename T, template <typename> class VertexPool>
+SplayTree<T, VertexPool>::SplayTree()
+  : pool_{}, root_{nullptr}, splay_counter_{0}, node_count_{0},
+    depth_factor_{0}, splay_strategy_{SplayStrategy::kAlways},
+    splay_parameter_{0}, accesses_to_splay_{0}, splay_threshold_{0},
+    random_state_{0x9e3779b97f4a7c15ULL} {}
 
 
-template <typename T>
-SplayTree<T>::SplayTree(const SplayTree& other) {*this = other;}
+template <typename T, template <typename> class VertexPool>
+SplayTree<T, VertexPool>::SplayTree(const SplayTree& other) : SplayTree() {
+  *this = other;
+}
 
-template <typename T>
-SplayTree<T>::~SplayTree() {
-  //clear deletes all the vertices
-  clear(root_);
-  root_ = nullptr;
+template <typename T, template <typename> class VertexPool>
+SplayTree<T, VertexPool>::~SplayTree() {
+  //clearAll deletes all the vertices
+  clearAll();
 }
 
 
 
-template <typename T>
-void SplayTree<T>::insert(T in_element) {
-  //creates the vertex holding in_element to be inserted into the tree
-  Vertex* new_vertex {new Vertex()};
-  new_vertex->element = in_element;
+template <typename T, template <typename> class VertexPool>
+void SplayTree<T, VertexPool>::insert(T&& element_in) {
+  //creates the vertex holding element_in to be inserted into the tree, and
+  //compares against its copy from here on since element_in was moved from
+  Vertex* new_vertex {pool_.create(std::move(element_in), nullptr, nullptr,
+				   nullptr)};
+  const T& in_element {new_vertex->element};
 
   Vertex* temp_vertex {root_};
   //after while loop below, parent holds vertex of new parent to new_vertex
   Vertex* parent {temp_vertex};
+  int depth {0};
   
   while(temp_vertex) {
     //when temp_vertex == nullptr, parent will hold correct parent of new_node
@@ -288,7 +642,10 @@ void SplayTree<T>::insert(T in_element) {
       temp_vertex = temp_vertex->left_child;
     else
       temp_vertex = temp_vertex->right_child;
+    ++depth;
   }
+  //one comparison per vertex passed, plus one more against parent below
+  WFC_STAT(long comparisons {depth + (parent ? 1L : 0L)});
   
   new_vertex->parent = parent;
   
@@ -298,58 +655,138 @@ void SplayTree<T>::insert(T in_element) {
     parent->left_child = new_vertex;
   else
     parent->right_child = new_vertex;
+  ++node_count_;
+  raiseMaxFrequency(new_vertex);
 
+  if (isTooDeep(depth))
+    depth = rebuildAround(new_vertex, depth);
+  WFC_STAT(stats_.recordAccess(depth, comparisons));
   //if new_vertex is not root, set it to root
-  splay(new_vertex->element);
-  ++node_count_;
+  if (shouldSplay(depth))
+    splay(new_vertex);
+}
+
+template <typename T, template <typename> class VertexPool>
+template <typename K>
+const T& SplayTree<T, VertexPool>::upsert(const K& key) {
+  bool found;
+  Vertex* key_vertex {findOrInsert(key, found)};
+  //element already in tree, bump its counter
+  if (found) {
+    (key_vertex->element).incrementFrequency();
+    raiseMaxFrequency(key_vertex);
+  }
+  return key_vertex->element;
+}
+
+template <typename T, template <typename> class VertexPool>
+const T& SplayTree<T, VertexPool>::accumulate(const T& element_in) {
+  bool found;
+  Vertex* key_vertex {findOrInsert(element_in, found)};
+  //element already in tree, add the other count to it
+  if (found) {
+    (key_vertex->element).addFrequency(element_in.getFrequency());
+    raiseMaxFrequency(key_vertex);
+  }
+  return key_vertex->element;
+}
+
+template <typename T, template <typename> class VertexPool>
+template <typename K>
+typename SplayTree<T, VertexPool>::Vertex*
+SplayTree<T, VertexPool>::findOrInsert(const K& key, bool& found) {
+  Vertex* temp_vertex {root_};
+  //after while loop below, parent holds the last vertex visited
+  Vertex* parent {nullptr};
+  bool went_left {false};
+  int depth {0};
+  WFC_STAT(long comparisons {0});
+
+  while(temp_vertex) {
+    if (key < temp_vertex->element)
+      went_left = true;
+    else if (temp_vertex->element < key)
+      went_left = false;
+    //neither is less than the other, so temp_vertex holds key
+    else
+      break;
+    //going left takes one comparison, going right takes both
+    WFC_STAT(comparisons += went_left ? 1 : 2);
+    ++depth;
+    parent = temp_vertex;
+    temp_vertex = went_left ? temp_vertex->left_child
+                            : temp_vertex->right_child;
+  }
+
+  found = temp_vertex != nullptr;
+  WFC_STAT(if (found) comparisons += 2);
+  //hang a new vertex off of the empty child slot we stopped at
+  if (!found) {
+    temp_vertex = pool_.create(key, nullptr, nullptr, parent);
+    if (!parent)
+      root_ = temp_vertex;
+    else if (went_left)
+      parent->left_child = temp_vertex;
+    else
+      parent->right_child = temp_vertex;
+    ++node_count_;
+    raiseMaxFrequency(temp_vertex);
+  }
+
+  if (isTooDeep(depth))
+    depth = rebuildAround(temp_vertex, depth);
+  WFC_STAT(stats_.recordAccess(depth, comparisons));
+  if (shouldSplay(depth))
+    splay(temp_vertex);
+  return temp_vertex;
 }
 
-template <typename T>
-void SplayTree<T>::remove(T element) {
+template <typename T, template <typename> class VertexPool>
+void SplayTree<T, VertexPool>::remove(const T& element) {
   Vertex* temp_vertex = findVertex(element);
   if (!temp_vertex)
     return;
 
   //sets the node to be removed to root position
-  splay(temp_vertex->element);
+  splay(temp_vertex);
 
   //no left children
   if(!temp_vertex->left_child) {
     root_ = temp_vertex->right_child;
-    root_->parent = nullptr;
+    if(root_)
+      root_->parent = nullptr;
   }
   //no right children
   else if (!temp_vertex->right_child) {
     root_ = temp_vertex->left_child;
     root_->parent = nullptr;
   }
-  // left & right children, set largest left descendant as root and right_child
-  // of new_vertex to the right_child of left_max
+  // left & right children, splay the largest left descendant to the top of
+  // the left subtree, where it has no right child, and hang the right
+  // subtree of temp_vertex off of it
   else {
-    Vertex* left_max = findVertex(findMax(temp_vertex->left_child));
-    //true when temp_vertex's parent is not root
-    if(left_max->parent != temp_vertex) {
-      left_max->parent->right_child = nullptr;
-      left_max->parent = nullptr;
-      left_max->left_child = temp_vertex->left_child;
-      left_max->left_child->parent = left_max;
-    }
+    root_ = temp_vertex->left_child;
+    root_->parent = nullptr;
+    Vertex* left_max {root_};
+    while(left_max->right_child)
+      left_max = left_max->right_child;
+    splay(left_max);
     //left_max is < right_child of temp_vertex, so ordering holds
     left_max->right_child = temp_vertex->right_child;
     left_max->right_child->parent = left_max;
-    root_ = left_max;
+    updateMaxFrequency(left_max);
   }
 
   //temp_vertex's existence was verified at beginning of function, so no
   //fear of deleting unallocated memory
-  delete temp_vertex;
+  pool_.destroy(temp_vertex);
   --node_count_;
 } 
 
 
 //currently returns T and not Vertex*
-template <typename T>
-T SplayTree<T>::findMin(Vertex* node) {
+template <typename T, template <typename> class VertexPool>
+T SplayTree<T, VertexPool>::findMin(Vertex* node) {
   if(!node)
     //return default initialized T object
     return T{};
@@ -357,14 +794,14 @@ T SplayTree<T>::findMin(Vertex* node) {
   Vertex* temp_vertex {node};
   while(temp_vertex->left_child)
     temp_vertex = temp_vertex->left_child;
-  splay(temp_vertex->element);
+  splay(temp_vertex);
   
   return temp_vertex->element;
 }
 
 //currently returns T and not Vertex*
-template <typename T>
-T SplayTree<T>::findMax(Vertex* node) {
+template <typename T, template <typename> class VertexPool>
+T SplayTree<T, VertexPool>::findMax(Vertex* node) {
   if(!node)
     //return default initialized T object
     return T{};
@@ -372,38 +809,26 @@ T SplayTree<T>::findMax(Vertex* node) {
   Vertex* temp_vertex {node};
   while(temp_vertex->right_child)
     temp_vertex = temp_vertex->right_child;
-  splay(temp_vertex->element);
+  splay(temp_vertex);
   
   return temp_vertex->element;
 }
 
-template <typename T>
-void SplayTree<T>::printTree() {
-  //calls internal print function
-  printTree(root_);
-}
-
-//recursive function, called for each descendant of node
-template <typename T>
-void SplayTree<T>::printTree(Vertex* node) {
-  if(node->left_child)
-    printTree(node->left_child);
-  if(node)
-    //assumes insertion operator "<<" is defined for T
-    std::cout << node->element << "\n";
-  if(node->right_child)
-    printTree(node->right_child);
+template <typename T, template <typename> class VertexPool>
+void SplayTree<T, VertexPool>::printTree() {
+  //assumes insertion operator "<<" is defined for T
+  visitInOrder([](const T& element) {std::cout << element << "\n";});
 }
 
-template <typename T>
-void SplayTree<T>::printRoot() const {
+template <typename T, template <typename> class VertexPool>
+void SplayTree<T, VertexPool>::printRoot() const {
   if(root_)
     std::cout << root_->element;
 }
 
 
-template <typename T>
-void SplayTree<T>::rightRotate(Vertex* node) {
+template <typename T, template <typename> class VertexPool>
+void SplayTree<T, VertexPool>::rightRotate(Vertex* node) {
   if (!node)
     return;
 
@@ -415,6 +840,9 @@ void SplayTree<T>::rightRotate(Vertex* node) {
     if(rotate_node->right_child) {rotate_node->right_child->parent = node;}
     rotate_node->right_child = node;
     rotate_node->parent = node->parent;
+    //rotate_node takes over node's subtree, node loses rotate_node's left
+    rotate_node->max_frequency = node->max_frequency;
+    updateMaxFrequency(node);
   }
 
   if(!node->parent)
@@ -429,8 +857,8 @@ void SplayTree<T>::rightRotate(Vertex* node) {
   node->parent = rotate_node;  
 }
 
-template <typename T>
-void SplayTree<T>::leftRotate(Vertex* node) {
+template <typename T, template <typename> class VertexPool>
+void SplayTree<T, VertexPool>::leftRotate(Vertex* node) {
   if (!node)
     return;
 
@@ -442,6 +870,9 @@ void SplayTree<T>::leftRotate(Vertex* node) {
     if(rotate_node->left_child) {rotate_node->left_child->parent = node;}
     rotate_node->left_child = node;
     rotate_node->parent = node->parent;
+    //rotate_node takes over node's subtree, node loses rotate_node's right
+    rotate_node->max_frequency = node->max_frequency;
+    updateMaxFrequency(node);
   }
   if(!node->parent)
     root_= rotate_node;
@@ -455,13 +886,56 @@ void SplayTree<T>::leftRotate(Vertex* node) {
   node->parent = rotate_node;
 }
 
-template <typename T> 
-void SplayTree<T>::splay(T element_in) {
-  if(!contains(element_in))
-    return;
+template <typename T, template <typename> class VertexPool>
+void SplayTree<T, VertexPool>::setSplayStrategy(SplayStrategy strategy,
+						double parameter) {
+  splay_strategy_ = strategy;
+  splay_parameter_ = 0;
+  splay_threshold_ = 0;
+  if (strategy == SplayStrategy::kEveryKth)
+    splay_parameter_ = std::max(1, static_cast<int>(parameter));
+  else if (strategy == SplayStrategy::kDeeperThan)
+    splay_parameter_ = std::max(0, static_cast<int>(parameter));
+  //a probability of 1 can't be written out of 2^64, so it always splays
+  else if (strategy == SplayStrategy::kRandom && parameter >= 1)
+    splay_strategy_ = SplayStrategy::kAlways;
+  else if (strategy == SplayStrategy::kRandom && parameter > 0)
+    splay_threshold_ = static_cast<std::uint64_t>(parameter * 0x1p64);
+  accesses_to_splay_ = splay_parameter_;
+}
+
+template <typename T, template <typename> class VertexPool>
+bool SplayTree<T, VertexPool>::shouldSplay(int depth) {
+  switch (splay_strategy_) {
+  case SplayStrategy::kEveryKth:
+    if (--accesses_to_splay_ > 0)
+      return false;
+    accesses_to_splay_ = splay_parameter_;
+    return true;
+  case SplayStrategy::kDeeperThan:
+    return depth > splay_parameter_;
+  case SplayStrategy::kRandom:
+    //xorshift64*, good enough to pick accesses and only a few instructions
+    random_state_ ^= random_state_ >> 12;
+    random_state_ ^= random_state_ << 25;
+    random_state_ ^= random_state_ >> 27;
+    return random_state_ * 0x2545f4914f6cdd1dULL < splay_threshold_;
+  default:
+    return true;
+  }
+}
+
+template <typename T, template <typename> class VertexPool>
+void SplayTree<T, VertexPool>::splay(const T& element_in) {
   //vertex to become the new root 
   Vertex* splay_vertex {findVertex(element_in)};
-  
+  if(!splay_vertex)
+    return;
+  splay(splay_vertex);
+}
+
+template <typename T, template <typename> class VertexPool>
+void SplayTree<T, VertexPool>::splay(Vertex* splay_vertex) {
   if (splay_vertex == root_)
     return;
 
@@ -471,11 +945,13 @@ void SplayTree<T>::splay(T element_in) {
     if(splay_vertex->parent == root_ &&
        splay_vertex->parent->left_child == splay_vertex) {
       rightRotate(splay_vertex->parent);    
+      WFC_STAT(++stats_.zig_count);
     }
     //when splay_vertex is right child of root
     else if (splay_vertex->parent == root_ &&
 	     splay_vertex->parent->right_child == splay_vertex) {
       leftRotate(splay_vertex->parent);          
+      WFC_STAT(++stats_.zig_count);
     }
     //when splay_vertex is left child of parent, and parent is the left
     //child of grandparent
@@ -483,6 +959,7 @@ void SplayTree<T>::splay(T element_in) {
 	     splay_vertex->parent->parent->left_child == splay_vertex->parent) {
       rightRotate(splay_vertex->parent->parent);
       rightRotate(splay_vertex->parent);           
+      WFC_STAT(++stats_.zig_zig_count);
     }
     //when splay_vertex is right child of parent, and parent is right child
     //of grandparent
@@ -490,6 +967,7 @@ void SplayTree<T>::splay(T element_in) {
 	     splay_vertex->parent->parent->right_child == splay_vertex->parent){
       leftRotate(splay_vertex->parent->parent);
       leftRotate(splay_vertex->parent);        
+      WFC_STAT(++stats_.zig_zig_count);
     }
     //when splay_vertex is left child of parent, and parent is the right child
     //of grandparent
@@ -498,6 +976,7 @@ void SplayTree<T>::splay(T element_in) {
 	     splay_vertex->parent) {
       rightRotate(splay_vertex->parent);
       leftRotate(splay_vertex->parent);          
+      WFC_STAT(++stats_.zig_zag_count);
     }
     //when splay_vertex is right child of parent, and parent is left child of
     //grandparent
@@ -506,6 +985,7 @@ void SplayTree<T>::splay(T element_in) {
 	     splay_vertex->parent) {
       leftRotate(splay_vertex->parent);
       rightRotate(splay_vertex->parent);         
+      WFC_STAT(++stats_.zig_zag_count);
     }
     //all cases should have been handled, so error if I get here
     else {
@@ -515,45 +995,485 @@ void SplayTree<T>::splay(T element_in) {
   }
 }
 
-template <typename T>
-void SplayTree<T>::findAll(const T& element) {
-  //call internal findAll function
-  findAll(element, root_);
+template <typename T, template <typename> class VertexPool>
+template <typename K>
+const T* SplayTree<T, VertexPool>::lookup(const K& key) const {
+  const Vertex* temp_vertex {root_};
+  while (temp_vertex) {
+    if (key < temp_vertex->element)
+      temp_vertex = temp_vertex->left_child;
+    else if (temp_vertex->element < key)
+      temp_vertex = temp_vertex->right_child;
+    else
+      return &temp_vertex->element;
+  }
+  return nullptr;
 }
 
+template <typename T, template <typename> class VertexPool>
+template <typename K, typename Visitor>
+void SplayTree<T, VertexPool>::findTop(const K& prefix, int k,
+				       Visitor visit) const {
+  //a candidate is a single vertex or a whole subtree of matches, ranked by
+  //its frequency or highest frequency; candidates hold disjoint ranges, so
+  //among equal ones the leftmost goes first, which keeps ties in order and
+  //only opens a subtree when it might hold the next element to visit
+  struct Candidate {
+    int frequency;
+    const Vertex* vertex;
+    bool whole_subtree;
+  };
+  auto ranks_below = [](const Candidate& a, const Candidate& b) {
+    if (a.frequency != b.frequency)
+      return a.frequency < b.frequency;
+    return b.vertex->element < a.vertex->element;
+  };
+  std::vector<Candidate> heap;
+  auto push = [&heap, &ranks_below](const Vertex* vertex, bool whole_subtree) {
+    if (!vertex)
+      return;
+    heap.push_back(Candidate{whole_subtree ? vertex->max_frequency
+			     : vertex->element.getFrequency(),
+			     vertex, whole_subtree});
+    std::push_heap(heap.begin(), heap.end(), ranks_below);
+  };
+  if (k <= 0)
+    return;
 
-template <typename T>
-void SplayTree<T>::findAll(const T& element_in, Vertex* node) {  
-  if (node) {
-    if (element_in % node->element) {
-      findAll(element_in, node->left_child);
-      std::cout << node->element << "\n";
-      findAll(element_in, node->right_child);
+  //go down to the highest vertex that matches, every match is under it
+  const Vertex* fork {root_};
+  while (fork && !fork->element.hasPrefix(prefix))
+    fork = fork->element < prefix ? fork->right_child : fork->left_child;
+  if (!fork)
+    return;
+  push(fork, false);
+  //along the left edge of the matches, a matching vertex has only matches 
+  //between it and fork, and the same goes for the right edge
+  for (const Vertex* left = fork->left_child; left; ) {
+    if (left->element.hasPrefix(prefix)) {
+      push(left, false);
+      push(left->right_child, true);
+      left = left->left_child;
+    }
+    else
+      left = left->right_child;
+  }
+  for (const Vertex* right = fork->right_child; right; ) {
+    if (right->element.hasPrefix(prefix)) {
+      push(right, false);
+      push(right->left_child, true);
+      right = right->right_child;
+    }
+    else
+      right = right->left_child;
+  }
+
+  while (k > 0 && !heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end(), ranks_below);
+    Candidate best {heap.back()};
+    heap.pop_back();
+    if (best.whole_subtree) {
+      push(best.vertex, false);
+      push(best.vertex->left_child, true);
+      push(best.vertex->right_child, true);
     }
     else {
-      findAll(element_in, node->left_child);
-      findAll(element_in, node->right_child);
+      visit(best.vertex->element);
+      --k;
     }
   }
 }
 
-//recursive function, called for each descendant of node
-template <typename T>
-void SplayTree<T>::clear(Vertex* node) {
-  if (node && node->left_child) 
-    clear(node->left_child);
-  if (node && node->right_child)
-    clear(node->right_child);
-  if(node)
-    delete node;
-  --node_count_;
+template <typename T, template <typename> class VertexPool>
+template <typename K, typename Visitor>
+void SplayTree<T, VertexPool>::findAll(const K& prefix, Visitor visit) const {
+  //holds the vertices still to be visited, smallest on top
+  std::vector<const Vertex*> pending;
+
+  //seek to the lower bound of prefix, keeping each vertex we pass on the
+  //left since those are the ones that come after it in order
+  const Vertex* node {root_};
+  while (node) {
+    if (node->element < prefix)
+      node = node->right_child;
+    else {
+      pending.push_back(node);
+      node = node->left_child;
+    }
+  }
+
+  //walk in order until an element no longer starts with prefix
+  while (!pending.empty()) {
+    node = pending.back();
+    pending.pop_back();
+    if (!(node->element).hasPrefix(prefix))
+      return;
+    visit(node->element);
+    for (node = node->right_child; node; node = node->left_child)
+      pending.push_back(node);
+  }
 }
 
-template <typename T>
-const SplayTree<T>& SplayTree<T>::operator=(const SplayTree& other) {
-  if(this != &other) {
+template <typename T, template <typename> class VertexPool>
+template <typename V, typename Visitor>
+void SplayTree<T, VertexPool>::walkInOrder(V* node, Visitor visit) {
+  if (!node)
+    return;
+  V* top {node->parent};
+  while (node->left_child)
+    node = node->left_child;
+  while (node != top) {
+    //climbing up through parent links moves on to the next vertex, unless
+    //we came up out of a right subtree, which has been visited already
+    V* next {node->right_child};
+    if (next) {
+      while (next->left_child)
+	next = next->left_child;
+    }
+    else {
+      V* child {node};
+      next = node->parent;
+      while (next != top && next->right_child == child) {
+	child = next;
+	next = next->parent;
+      }
+    }
+    visit(node);
+    node = next;
+  }
+}
+
+template <typename T, template <typename> class VertexPool>
+int SplayTree<T, VertexPool>::getHeight() const {
+  //walk the vertices in preorder, keeping track of the depth on the way
+  const Vertex* node {root_};
+  int depth {0};
+  int height {-1};
+  while (node) {
+    if (depth > height)
+      height = depth;
+    if (node->left_child || node->right_child) {
+      node = node->left_child ? node->left_child : node->right_child;
+      ++depth;
+      continue;
+    }
+    //climb until we come up out of a left subtree that has a right sibling
+    const Vertex* child;
+    do {
+      child = node;
+      node = node->parent;
+      --depth;
+    } while (node && (node->right_child == child || !node->right_child));
+    if (node) {
+      node = node->right_child;
+      ++depth;
+    }
+  }
+  return height;
+}
+
+template <typename T, template <typename> class VertexPool>
+void SplayTree<T, VertexPool>::clear(Vertex* node) {
+  //take leaves off from the bottom until node itself is a leaf and goes
+  Vertex* top {node ? node->parent : nullptr};
+  while (node != top) {
+    if (node->left_child)
+      node = node->left_child;
+    else if (node->right_child)
+      node = node->right_child;
+    else {
+      Vertex* parent {node->parent};
+      if (parent && parent->left_child == node)
+	parent->left_child = nullptr;
+      else if (parent)
+	parent->right_child = nullptr;
+      pool_.destroy(node);
+      --node_count_;
+      node = parent;
+    }
+  }
+}
+
+template <typename T, template <typename> class VertexPool>
+typename SplayTree<T, VertexPool>::Vertex*
+SplayTree<T, VertexPool>::copy(const Vertex* old) {
+  if (!old)
+    return nullptr;
+  Vertex* new_root {pool_.create(old->element, nullptr, nullptr, nullptr)};
+  new_root->max_frequency = old->max_frequency;
+  //walk old in preorder through parent links, taking every step in the 
+  //copy as well, and going down a side only if it hasn't been copied yet
+  Vertex* new_vertex {new_root};
+  while (true) {
+    if (old->left_child && !new_vertex->left_child) {
+      old = old->left_child;
+      new_vertex->left_child = pool_.create(old->element, nullptr, nullptr,
+					    new_vertex);
+      new_vertex = new_vertex->left_child;
+      new_vertex->max_frequency = old->max_frequency;
+    }
+    else if (old->right_child && !new_vertex->right_child) {
+      old = old->right_child;
+      new_vertex->right_child = pool_.create(old->element, nullptr, nullptr,
+					     new_vertex);
+      new_vertex = new_vertex->right_child;
+      new_vertex->max_frequency = old->max_frequency;
+    }
+    else if (new_vertex == new_root)
+      break;
+    else {
+      old = old->parent;
+      new_vertex = new_vertex->parent;
+    }
+  }
+  return new_root;
+}
+
+template <typename T, template <typename> class VertexPool>
+int SplayTree<T, VertexPool>::rebuildAround(Vertex* deep_vertex,
+					    int depth) {
+  //count the vertices under each ancestor in turn, until rebuilding the
+  //ancestor into a balanced subtree would leave deep_vertex shallow enough
+  int limit {depth_factor_ * bitWidth(node_count_)};
+  Vertex* subtree {deep_vertex};
+  int size {0};
+  walkInOrder(subtree, [&size](Vertex*) {++size;});
+  while (subtree->parent && depth + bitWidth(size) > limit) {
+    Vertex* parent {subtree->parent};
+    Vertex* sibling {parent->left_child == subtree ? parent->right_child
+		                                   : parent->left_child};
+    ++size;
+    walkInOrder(sibling, [&size](Vertex*) {++size;});
+    subtree = parent;
+    --depth;
+  }
+
+  std::vector<Vertex*> vertices;
+  vertices.reserve(size);
+  walkInOrder(subtree, [&vertices](Vertex* vertex) {
+      vertices.push_back(vertex);
+    });
+  Vertex* parent {subtree->parent};
+  Vertex* balanced {linkRange(vertices, 0, vertices.size(), parent)};
+  if (!parent)
+    root_ = balanced;
+  else if (parent->left_child == subtree)
+    parent->left_child = balanced;
+  else
+    parent->right_child = balanced;
+  WFC_STAT(++stats_.rebuild_count);
+  WFC_STAT(stats_.rebuilt_vertices += size);
+
+  for (depth = 0; deep_vertex->parent; deep_vertex = deep_vertex->parent)
+    ++depth;
+  return depth;
+}
+
+//recursive function, depth is only log2 of the number of vertices
+template <typename T, template <typename> class VertexPool>
+typename SplayTree<T, VertexPool>::Vertex*
+SplayTree<T, VertexPool>::linkRange(const std::vector<Vertex*>& vertices,
+				    std::size_t first, std::size_t last,
+				    Vertex* parent) {
+  if (first == last)
+    return nullptr;
+  std::size_t middle {first + (last - first) / 2};
+  Vertex* vertex {vertices[middle]};
+  vertex->parent = parent;
+  vertex->left_child = linkRange(vertices, first, middle, vertex);
+  vertex->right_child = linkRange(vertices, middle + 1, last, vertex);
+  updateMaxFrequency(vertex);
+  return vertex;
+}
+
+template <typename T, template <typename> class VertexPool>
+void SplayTree<T, VertexPool>::clearAll() {
+  //elements with nothing to clean up are dropped along with their slabs
+  if (!std::is_trivially_destructible<T>::value ||
+      !VertexPool<Vertex>::kBulkRelease)
     clear(root_);
+  pool_.release();
+  root_ = nullptr;
+  node_count_ = 0;
+}
+
+template <typename T, template <typename> class VertexPool>
+template <typename Make>
+void SplayTree<T, VertexPool>::buildFromSorted(std::size_t count, Make make) {
+  clearAll();
+  pool_.reserve(count);
+  root_ = buildRange(make, 0, count, nullptr);
+  node_count_ = static_cast<int>(count);
+}
+
+//recursive function, depth is only log2 of the number of elements
+template <typename T, template <typename> class VertexPool>
+template <typename Make>
+typename SplayTree<T, VertexPool>::Vertex*
+SplayTree<T, VertexPool>::buildRange(Make& make, std::size_t first,
+				     std::size_t last, Vertex* parent) {
+  if (first == last)
+    return nullptr;
+  //build left to right so make is called with indexes in increasing order
+  std::size_t middle {first + (last - first) / 2};
+  Vertex* left {buildRange(make, first, middle, nullptr)};
+  Vertex* new_vertex {pool_.create(make(middle), left, nullptr, parent)};
+  if (left)
+    left->parent = new_vertex;
+  new_vertex->right_child = buildRange(make, middle + 1, last, new_vertex);
+  updateMaxFrequency(new_vertex);
+  return new_vertex;
+}
+
+template <typename T, template <typename> class VertexPool>
+void SplayTree<T, VertexPool>::split(const T& key, SplayTree& greater) {
+  greater.clearAll();
+  if (!root_)
+    return;
+
+  //splay the last vertex on the search path for key, which is the closest 
+  //element on one side of it
+  Vertex* temp_vertex {root_};
+  Vertex* last {nullptr};
+  while (temp_vertex) {
+    last = temp_vertex;
+    temp_vertex = temp_vertex->element < key ? temp_vertex->right_child
+                                             : temp_vertex->left_child;
+  }
+  splay(last);
+
+  //cut the root from its right subtree, or keep only its left subtree
+  Vertex* cut;
+  Vertex* kept;
+  if (root_->element < key) {
+    cut = root_->right_child;
+    root_->right_child = nullptr;
+    kept = root_;
+  }
+  else {
+    cut = root_;
+    kept = root_->left_child;
+    root_->left_child = nullptr;
+  }
+  updateMaxFrequency(root_);
+  if (cut)
+    cut->parent = nullptr;
+  if (kept)
+    kept->parent = nullptr;
+
+  int cut_count {countFirst(cut, kept, node_count_)};
+  greater.pool_.share(pool_);
+  greater.root_ = cut;
+  greater.node_count_ = cut_count;
+  root_ = kept;
+  node_count_ -= cut_count;
+}
+
+template <typename T, template <typename> class VertexPool>
+void SplayTree<T, VertexPool>::join(SplayTree& greater) {
+  if (this == &greater || !greater.root_)
+    return;
+
+  pool_.share(greater.pool_);
+  if (!root_)
+    root_ = greater.root_;
+  else {
+    //the largest element has no right child once it is the root
+    Vertex* max_vertex {root_};
+    while (max_vertex->right_child)
+      max_vertex = max_vertex->right_child;
+    splay(max_vertex);
+    root_->right_child = greater.root_;
+    greater.root_->parent = root_;
+    updateMaxFrequency(root_);
+  }
+  node_count_ += greater.node_count_;
+  WFC_STAT(stats_ += greater.stats_);
+
+  //the vertices belong to this tree now, so greater only lets go of them
+  greater.root_ = nullptr;
+  greater.node_count_ = 0;
+  greater.pool_.release();
+}
+
+template <typename T, template <typename> class VertexPool>
+template <typename Adopt>
+void SplayTree<T, VertexPool>::unite(const SplayTree& other, Adopt adopt) {
+  std::vector<T> mine;
+  std::vector<const T*> theirs;
+  mine.reserve(node_count_);
+  theirs.reserve(other.node_count_);
+  visitInOrder([&mine](const T& element) {mine.push_back(element);});
+  other.visitInOrder([&theirs](const T& element) {
+      theirs.push_back(&element);
+    });
+
+  //merge the two sorted sequences, adding up the frequencies of equal ones
+  std::vector<T> merged;
+  merged.reserve(mine.size() + theirs.size());
+  std::size_t i {0};
+  std::size_t j {0};
+  while (i < mine.size() || j < theirs.size()) {
+    if (j == theirs.size() || (i < mine.size() && mine[i] < *theirs[j]))
+      merged.push_back(std::move(mine[i++]));
+    else if (i == mine.size() || *theirs[j] < mine[i])
+      merged.push_back(adopt(*theirs[j++]));
+    else {
+      merged.push_back(std::move(mine[i++]));
+      merged.back().addFrequency(theirs[j++]->getFrequency());
+    }
+  }
+
+  buildFromSorted(merged.size(), [&merged](std::size_t k) {
+      return std::move(merged[k]);
+    });
+}
+
+template <typename T, template <typename> class VertexPool>
+int SplayTree<T, VertexPool>::countFirst(const Vertex* first,
+					 const Vertex* second, int total) {
+  std::vector<const Vertex*> first_stack;
+  std::vector<const Vertex*> second_stack;
+  if (first)
+    first_stack.push_back(first);
+  if (second)
+    second_stack.push_back(second);
+  int first_count {0};
+  int second_count {0};
+
+  //take one vertex off of each side in turn until one side runs out
+  auto step = [](std::vector<const Vertex*>& stack, int& count) {
+    const Vertex* vertex {stack.back()};
+    stack.pop_back();
+    ++count;
+    if (vertex->left_child)
+      stack.push_back(vertex->left_child);
+    if (vertex->right_child)
+      stack.push_back(vertex->right_child);
+  };
+  while (!first_stack.empty() && !second_stack.empty()) {
+    step(first_stack, first_count);
+    step(second_stack, second_count);
+  }
+  return first_stack.empty() ? first_count : total - second_count;
+}
+
+template <typename T, template <typename> class VertexPool>
+const SplayTree<T, VertexPool>& SplayTree<T, VertexPool>::operator=(const SplayTree& other) {
+  if(this != &other) {
+    clearAll();
+    //every vertex of the copy comes out of a single slab
+    pool_.reserve(other.node_count_);
     root_ = copy(other.root_);
+    node_count_ = other.node_count_;
+    splay_counter_ = other.splay_counter_;
+    depth_factor_ = other.depth_factor_;
+    splay_strategy_ = other.splay_strategy_;
+    splay_parameter_ = other.splay_parameter_;
+    accesses_to_splay_ = other.accesses_to_splay_;
+    splay_threshold_ = other.splay_threshold_;
+    random_state_ = other.random_state_;
+    WFC_STAT(stats_ = other.stats_);
   }
   return *this;
 }
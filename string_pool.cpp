@@ -0,0 +1,37 @@
+#include <cstring>   // for memcpy
+
+#include "string_pool.h"
+
+StringPool::StringPool()
+  : chunks_{},
+    cursor_{nullptr},
+    chunk_end_{nullptr},
+    bytes_used_{0},
+    bytes_allocated_{0} {}
+
+std::string_view StringPool::intern(std::string_view word) {
+  if (word.empty())
+    return std::string_view();
+
+  char* copy;
+  if (word.size() > LARGE_WORD_SIZE)
+    copy = addChunk(word.size());
+  else {
+    //start a new chunk once the word no longer fits in the current one
+    if (static_cast<std::size_t>(chunk_end_ - cursor_) < word.size()) {
+      cursor_ = addChunk(CHUNK_SIZE);
+      chunk_end_ = cursor_ + CHUNK_SIZE;
+    }
+    copy = cursor_;
+    cursor_ += word.size();
+  }
+  std::memcpy(copy, word.data(), word.size());
+  bytes_used_ += word.size();
+  return std::string_view(copy, word.size());
+}
+
+char* StringPool::addChunk(std::size_t size) {
+  chunks_.emplace_back(new char[size]);
+  bytes_allocated_ += size;
+  return chunks_.back().get();
+}
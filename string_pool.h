@@ -0,0 +1,68 @@
+/** 
+ *
+ */
+#ifndef STRING_POOL_H_
+#define STRING_POOL_H_
+
+#include <cstddef>       // for size_t
+#include <memory>        // for unique_ptr
+#include <string_view>   // for string_view
+#include <vector>        // for vector
+
+/**
+ * StringPool is an append-only arena that words are copied into once, so
+ *   that everything referring to a word can hold a view of the copy instead
+ *   of a string of its own. Words are packed one after another into large
+ *   chunks, without terminators or per-word headers. Chunks are never moved
+ *   or freed before the pool itself, so every view handed out stays valid
+ *   for as long as the pool exists. Interning is not thread safe, but views
+ *   of words already interned may be read from any thread while more words
+ *   are being added.
+ */
+class StringPool {
+ public:
+  /**
+   * StringPool no-arg constructor.
+   *   Starts out with no chunks allocated.
+   */
+  StringPool();
+
+  StringPool(const StringPool&) = delete;
+  StringPool& operator=(const StringPool&) = delete;
+
+  /**
+   * Copies word into the pool and returns a view of the copy.
+   *   @param word The word to be copied.
+   */
+  std::string_view intern(std::string_view word);
+
+  /**
+   * Returns the number of bytes of words copied into the pool.
+   */
+  std::size_t getBytesUsed() const {return bytes_used_;}
+
+  /**
+   * Returns the number of bytes allocated for chunks.
+   */
+  std::size_t getBytesAllocated() const {return bytes_allocated_;}
+
+ private:
+  static const std::size_t CHUNK_SIZE = 65536;
+  // words longer than this get a chunk of their own, so that they don't
+  // leave most of the current chunk unused
+  static const std::size_t LARGE_WORD_SIZE = CHUNK_SIZE / 4;
+
+  /**
+   * Allocates a chunk of size bytes and returns where it starts.
+   *   @param size The number of bytes in the chunk.
+   */
+  char* addChunk(std::size_t size);
+
+  std::vector<std::unique_ptr<char[]>> chunks_;
+  char* cursor_;      // where the next word goes in the current chunk
+  char* chunk_end_;   // one past the end of the current chunk
+  std::size_t bytes_used_;
+  std::size_t bytes_allocated_;
+};
+
+#endif //STRING_POOL_H_
@@ -0,0 +1,35 @@
+/** 
+ *
+ */
+#ifndef TESTS_CHECK_H_
+#define TESTS_CHECK_H_
+
+#include <iostream>      // for cerr
+
+/** 
+ * CHECK reports cond as a failure, with where it is, if it is false, and 
+ *   counts it in check_failures. A test program returns checkResult() from 
+ *   main, so make check stops at the first program that failed. 
+ */
+inline int check_failures = 0;
+
+#define CHECK(cond)							\
+  do {									\
+    if (!(cond)) {							\
+      std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond	\
+		<< ") failed\n";					\
+      ++check_failures;							\
+    }									\
+  } while (false)
+
+/** 
+ * Prints how many checks failed, if any, and returns the exit status of 
+ *   the test program. 
+ */
+inline int checkResult() {
+  if (check_failures != 0)
+    std::cerr << check_failures << " check(s) failed\n";
+  return check_failures == 0 ? 0 : 1;
+}
+
+#endif //TESTS_CHECK_H_
@@ -0,0 +1,183 @@
+#include <unistd.h>      // for close, unlink, write
+
+#include <cstdlib>       // for mkstemp
+#include <fstream>       // for ifstream
+#include <memory>        // for make_unique
+#include <sstream>       // for stringstream
+#include <string>        // for string
+#include <thread>        // for thread
+#include <utility>       // for pair
+#include <vector>        // for vector
+
+#include "check.h"
+#include "hashed_splays.h"
+
+namespace {
+
+const char* const INPUT = "input2.txt";
+
+//a first letter table needs a tree for every letter, a hashed one grows
+template <typename Bucketing>
+int treesFor(Bucketing bucketing) {
+  return bucketing == Bucketing::kFirstLetter ? 26 : 4;
+}
+
+//every word of table with its frequency, in sorted order
+template <typename Table>
+std::vector<std::pair<std::string, int>> wordsOf(const Table& table) {
+  std::vector<std::pair<std::string, int>> words;
+  for (const Node& node : table.findContaining(""))
+    words.emplace_back(node.getWord(), node.getFrequency());
+  return words;
+}
+
+//a copy keeps its words after the original is gone, and counting into the
+//copy and the original at the same time from two threads leaves each with
+//its own counts
+template <typename Table>
+void testCopiesAreIndependent(typename Table::Bucketing bucketing) {
+  auto original = std::make_unique<Table>(treesFor(bucketing), bucketing);
+  original->setInfixIndexing(true);
+  original->processWordsFromFile(INPUT);
+  auto counted_once = wordsOf(*original);
+  int the_once {original->getFrequency("the")};
+  CHECK(the_once > 0);
+
+  Table copy(*original);
+  CHECK(wordsOf(copy) == counted_once);
+
+  std::thread other([&original]() {
+      original->processWordsFromFile(INPUT);
+    });
+  copy.processWordsFromFile(INPUT);
+  copy.processWordsFromFile(INPUT);
+  other.join();
+  CHECK(original->getFrequency("the") == 2 * the_once);
+  CHECK(copy.getFrequency("the") == 3 * the_once);
+
+  //the leaders and the infix index of a copy refer to its own words
+  Table assigned(treesFor(bucketing), bucketing);
+  assigned = copy;
+  original.reset();
+  copy = Table(treesFor(bucketing), bucketing);
+  CHECK(copy.getFrequency("the") == 0);
+  CHECK(assigned.getFrequency("the") == 3 * the_once);
+  CHECK(assigned.getTopWords(1).front().getWord() == "the");
+  CHECK(assigned.findContaining("the").size() > 1);
+  CHECK(wordsOf(assigned).size() == counted_once.size());
+}
+
+//the words of nodes with their frequencies, in the order given
+std::vector<std::pair<std::string, int>> wordsOf(
+    const std::vector<Node>& nodes) {
+  std::vector<std::pair<std::string, int>> words;
+  for (const Node& node : nodes)
+    words.emplace_back(node.getWord(), node.getFrequency());
+  return words;
+}
+
+//counting in shards and merging them once at the end gives the same words,
+//leaders and infix matches as counting on one thread
+template <typename Table>
+void testShardsMatchSerial(typename Table::Bucketing bucketing) {
+  Table serial(treesFor(bucketing), bucketing);
+  serial.setTopCapacity(10);
+  serial.setInfixIndexing(true);
+  serial.processWordsFromFile(INPUT);
+  Table sharded(treesFor(bucketing), bucketing);
+  sharded.setTopCapacity(10);
+  sharded.setInfixIndexing(true);
+  sharded.processWordsFromFile(INPUT, 4);
+  CHECK(wordsOf(sharded) == wordsOf(serial));
+  CHECK(wordsOf(sharded.getTopWords(10)) == wordsOf(serial.getTopWords(10)));
+  CHECK(wordsOf(sharded.findContaining("the")) ==
+	wordsOf(serial.findContaining("the")));
+}
+
+//the words of table that writeMatches writes for in_part, one per line
+template <typename Table>
+std::string matchesOf(Table& table, const std::string& in_part) {
+  char file_name[] {"/tmp/hashed_splays_testXXXXXX"};
+  int descriptor {mkstemp(file_name)};
+  close(descriptor);
+  WordSink sink(WordSink::Format::kTsv);
+  sink.open(file_name);
+  table.writeMatches(in_part, sink);
+  sink.close();
+  std::ifstream written(file_name);
+  std::stringstream contents;
+  contents << written.rdbuf();
+  unlink(file_name);
+  return contents.str();
+}
+
+//with case folding on, a query in any case finds the lowercase words, and
+//bytes above 0x7f are dropped from words without upsetting the query
+template <typename Table>
+void testFoldedQueries(typename Table::Bucketing bucketing) {
+  char file_name[] {"/tmp/hashed_splays_testXXXXXX"};
+  int descriptor {mkstemp(file_name)};
+  const std::string text {"The theory of THEM \xe9t\xe9 \xc9t\xc9 caf\xe9\n"};
+  CHECK(write(descriptor, text.data(), text.size()) ==
+	static_cast<ssize_t>(text.size()));
+  close(descriptor);
+
+  Table table(treesFor(bucketing), bucketing);
+  table.setFoldCase(true);
+  table.processWordsFromFile(file_name);
+  unlink(file_name);
+  std::string lower {matchesOf(table, "the")};
+  CHECK(lower == "the\t1\nthem\t1\ntheory\t1\n");
+  CHECK(matchesOf(table, "THE") == lower);
+  CHECK(matchesOf(table, "tHe") == lower);
+  CHECK(matchesOf(table, "THEO") == "theory\t1\n");
+  CHECK(table.complete("THE", 1).size() == 1);
+  CHECK(table.getFrequency("CAF\xe9") == 0);
+  CHECK(table.getFrequency("CAF") == 1);
+  //bytes past 0x7f are never part of a word, but may still be asked for
+  if (bucketing != Table::Bucketing::kFirstLetter)
+    CHECK(matchesOf(table, "\xc9t") == "");
+}
+
+//a saved table only loads with enough trees for its bucketing, and a file
+//that is turned down leaves the table as it was
+template <typename Table>
+void testLoadChecksTreeCount() {
+  char file_name[] {"/tmp/hashed_splays_testXXXXXX"};
+  close(mkstemp(file_name));
+  Table table(26, Table::Bucketing::kFirstLetter);
+  table.processWordsFromFile(INPUT);
+  auto counted = wordsOf(table);
+
+  Table too_few(4, Table::Bucketing::kFirstLetter);
+  CHECK(too_few.saveToFile(file_name));
+  CHECK(!table.loadFromFile(file_name));
+  CHECK(wordsOf(table) == counted);
+
+  CHECK(table.saveToFile(file_name));
+  Table loaded(26, Table::Bucketing::kFirstLetter);
+  CHECK(loaded.loadFromFile(file_name));
+  CHECK(wordsOf(loaded) == counted);
+  unlink(file_name);
+}
+
+}  // namespace
+
+int main() {
+  testCopiesAreIndependent<HashedSplays>(HashedSplays::Bucketing::kFirstLetter);
+  testCopiesAreIndependent<HashedSplays>(HashedSplays::Bucketing::kHashed);
+  using FlatTable = BasicHashedSplays<FlatCountMap<Node>>;
+  testCopiesAreIndependent<FlatTable>(FlatTable::Bucketing::kHashed);
+  using BlockTable = BasicHashedSplays<SortedBlockMap<Node>>;
+  testCopiesAreIndependent<BlockTable>(BlockTable::Bucketing::kFirstLetter);
+  testShardsMatchSerial<HashedSplays>(HashedSplays::Bucketing::kFirstLetter);
+  testShardsMatchSerial<HashedSplays>(HashedSplays::Bucketing::kHashed);
+  testShardsMatchSerial<FlatTable>(FlatTable::Bucketing::kHashed);
+  testShardsMatchSerial<BlockTable>(BlockTable::Bucketing::kFirstLetter);
+  testFoldedQueries<HashedSplays>(HashedSplays::Bucketing::kFirstLetter);
+  testFoldedQueries<HashedSplays>(HashedSplays::Bucketing::kHashed);
+  testFoldedQueries<FlatTable>(FlatTable::Bucketing::kHashed);
+  testFoldedQueries<BlockTable>(BlockTable::Bucketing::kFirstLetter);
+  testLoadChecksTreeCount<HashedSplays>();
+  return checkResult();
+}
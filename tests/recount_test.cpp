@@ -0,0 +1,62 @@
+#include <cstdlib>       // for malloc, free
+#include <new>           // for bad_alloc
+
+#include "check.h"
+#include "hashed_splays.h"
+
+//every allocation made by the test goes through here, so a recount can be
+//checked for calls to operator new
+static long allocation_count = 0;
+
+void* operator new(std::size_t size) {
+  ++allocation_count;
+  if (void* memory = std::malloc(size ? size : 1))
+    return memory;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {std::free(memory);}
+
+void operator delete(void* memory, std::size_t) noexcept {std::free(memory);}
+
+namespace {
+
+//counting a file into a table that has already counted it must not call
+//operator new, whatever the bucket, bucketing and case folding
+template <typename Table>
+void testRecountDoesNotAllocate(typename Table::Bucketing bucketing,
+				bool fold_case) {
+  for (const char* file_name : {"input1.txt", "input2.txt"}) {
+    Table table(bucketing == Table::Bucketing::kFirstLetter ? 26 : 4,
+		bucketing);
+    table.setFoldCase(fold_case);
+    table.processWordsFromFile(file_name);
+    int the_once {table.getFrequency("the")};
+    long allocations_before {allocation_count};
+    table.processWordsFromFile(file_name);
+    long allocations {allocation_count - allocations_before};
+    CHECK(allocations == 0);
+    if (allocations != 0)
+      std::cerr << "  " << allocations << " allocations recounting "
+		<< file_name << "\n";
+    CHECK(table.getFrequency("the") == 2 * the_once);
+  }
+}
+
+template <typename Table>
+void testEveryConfiguration() {
+  for (bool fold_case : {false, true}) {
+    testRecountDoesNotAllocate<Table>(Table::Bucketing::kFirstLetter,
+				      fold_case);
+    testRecountDoesNotAllocate<Table>(Table::Bucketing::kHashed, fold_case);
+  }
+}
+
+}  // namespace
+
+int main() {
+  testEveryConfiguration<HashedSplays>();
+  testEveryConfiguration<BasicHashedSplays<FlatCountMap<Node>>>();
+  testEveryConfiguration<BasicHashedSplays<SortedBlockMap<Node>>>();
+  return checkResult();
+}
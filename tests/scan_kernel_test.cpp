@@ -0,0 +1,148 @@
+#include <cstddef>       // for size_t
+#include <cstdint>       // for uint64_t
+#include <random>        // for mt19937, uniform_int_distribution
+#include <string>        // for string
+#include <string_view>   // for string_view
+#include <vector>        // for vector
+
+#include "check.h"
+#include "scan_kernel.h"
+#include "tokenizer.h"
+
+namespace {
+
+const ScanKernel::Level kLevels[] {ScanKernel::kScalar, ScanKernel::kSse2,
+				   ScanKernel::kAvx2};
+
+//bytes next to the edges of each class, where a vector compare that is off
+//by one or signed the wrong way would go wrong, plus every high byte edge
+const unsigned char kTrickyBytes[] {
+  0x00, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x1f, 0x20, 0x21, '0',
+  '9', 0x40, 'A', 'M', 'Z', 0x5b, 0x5e, '_', 0x60, 'a', 'm', 'z', 0x7b,
+  0x7f, 0x80, 0x81, 0x89, 0x8a, 0xa0, 0xc1, 0xc9, 0xda, 0xdf, 0xe0, 0xe1,
+  0xe9, 0xfa, 0xff};
+
+//a byte at a time, straight from the definition of a word in tokenizer.h
+std::vector<std::string> referenceWords(const std::vector<char>& text,
+					bool fold_case) {
+  std::vector<std::string> words;
+  std::string word;
+  for (std::size_t i = 0; i <= text.size(); ++i) {
+    unsigned char c {i < text.size() ? static_cast<unsigned char>(text[i])
+				     : static_cast<unsigned char>(' ')};
+    if (c == ' ' || (c >= '\t' && c <= '\r')) {
+      if (!word.empty())
+	words.push_back(word);
+      word.clear();
+    } else if (c >= 'A' && c <= 'Z') {
+      word += static_cast<char>(fold_case ? c + ('a' - 'A') : c);
+    } else if ((c >= 'a' && c <= 'z') || c == '_') {
+      word += static_cast<char>(c);
+    }
+  }
+  return words;
+}
+
+std::vector<std::string> tokenizerWords(const std::vector<char>& text,
+					ScanKernel::Level level,
+					bool fold_case) {
+  Tokenizer tokenizer(text.data(), text.data() + text.size());
+  tokenizer.setKernel(ScanKernel(level));
+  tokenizer.setFoldCase(fold_case);
+  std::vector<std::string> words;
+  std::string_view word;
+  while (tokenizer.next(word))
+    words.emplace_back(word);
+  return words;
+}
+
+std::vector<char> randomText(std::mt19937& random, std::size_t size) {
+  std::uniform_int_distribution<int> pick_kind(0, 3);
+  std::uniform_int_distribution<int> pick_any(0, 255);
+  std::uniform_int_distribution<std::size_t> pick_tricky(
+      0, sizeof(kTrickyBytes) - 1);
+  std::uniform_int_distribution<int> pick_letter(0, 25);
+  std::vector<char> text(size);
+  for (char& c : text) {
+    switch (pick_kind(random)) {
+      case 0:
+	c = static_cast<char>(pick_any(random));
+	break;
+      case 1:
+	c = static_cast<char>(kTrickyBytes[pick_tricky(random)]);
+	break;
+      case 2:
+	c = static_cast<char>('a' + pick_letter(random));
+	break;
+      default:
+	c = ' ';
+    }
+  }
+  return text;
+}
+
+//every byte value in every position of a block, against the class table
+void testClassifyBlock() {
+  for (ScanKernel::Level level : kLevels) {
+    if (!ScanKernel::isSupported(level))
+      continue;
+    ScanKernel kernel(level);
+    char block[ScanKernel::kBlockSize];
+    for (int value = 0; value < 256; ++value) {
+      for (std::size_t i = 0; i < ScanKernel::kBlockSize; ++i)
+	block[i] = static_cast<char>((value + i * 7) % 256);
+      std::uint64_t word_mask;
+      std::uint64_t space_mask;
+      kernel.classifyBlock(block, word_mask, space_mask);
+      for (std::size_t i = 0; i < ScanKernel::kBlockSize; ++i) {
+	CHECK((word_mask >> i & 1) == ScanKernel::isWordChar(block[i]));
+	CHECK((space_mask >> i & 1) == ScanKernel::isSpace(block[i]));
+      }
+    }
+  }
+}
+
+//every size up to a few vectors, so each level's tail is folded too
+void testFoldCase() {
+  std::mt19937 random(7);
+  for (ScanKernel::Level level : kLevels) {
+    if (!ScanKernel::isSupported(level))
+      continue;
+    ScanKernel kernel(level);
+    for (std::size_t size = 0; size <= 100; ++size) {
+      std::vector<char> in {randomText(random, size)};
+      std::vector<char> out(size);
+      kernel.foldCase(out.data(), in.data(), size);
+      for (std::size_t i = 0; i < size; ++i)
+	CHECK(out[i] == ScanKernel::foldChar(in[i]));
+      kernel.foldCase(in.data(), in.data(), size);
+      CHECK(in == out);
+    }
+  }
+}
+
+//buffers of every length around the block size, which end mid word, mid
+//run of spaces and on a block edge
+void testTokenizer() {
+  std::mt19937 random(11);
+  for (std::size_t size = 0; size <= 3 * ScanKernel::kBlockSize + 1; ++size) {
+    for (int round = 0; round < 20; ++round) {
+      std::vector<char> text {randomText(random, size)};
+      for (bool fold_case : {false, true}) {
+	std::vector<std::string> expected {referenceWords(text, fold_case)};
+	for (ScanKernel::Level level : kLevels)
+	  if (ScanKernel::isSupported(level))
+	    CHECK(tokenizerWords(text, level, fold_case) == expected);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main() {
+  testClassifyBlock();
+  testFoldCase();
+  testTokenizer();
+  return checkResult();
+}
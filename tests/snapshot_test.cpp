@@ -0,0 +1,92 @@
+#include <atomic>        // for atomic
+#include <memory>        // for shared_ptr
+#include <thread>        // for thread
+#include <vector>        // for vector
+
+#include "check.h"
+#include "hashed_splays.h"
+
+namespace {
+
+const char* const INPUT = "input2.txt";
+const int kPasses = 10;
+const int kReaders = 3;
+
+//what one reader saw, checked on the main thread once it has stopped
+struct ReaderLog {
+  int went_backwards = 0;  // times a count was lower than the one before
+  int torn = 0;            // times a snapshot held part of a pass
+};
+
+//one writer counts the input again and again, publishing a snapshot after
+//every pass, while readers query whichever snapshot is current; a reader
+//must only ever see whole passes, and never fewer than it saw before
+template <typename Table>
+void testReadersSeeWholePasses(typename Table::Bucketing bucketing) {
+  int trees {bucketing == Table::Bucketing::kFirstLetter ? 26 : 4};
+  Table once(trees, bucketing);
+  once.processWordsFromFile(INPUT);
+  int the_once {once.getFrequency("the")};
+  long th_once {0};
+  once.publishSnapshot();
+  once.getSnapshot()->findAll("th", [&th_once](const Node& node) {
+      th_once += node.getFrequency();
+    });
+  CHECK(the_once > 0);
+
+  Table table(trees, bucketing);
+  CHECK(table.getSnapshot() == nullptr);
+  std::atomic<bool> done {false};
+  std::vector<ReaderLog> logs(kReaders);
+  std::vector<std::thread> readers;
+  for (int i = 0; i < kReaders; ++i) {
+    readers.emplace_back([&table, &done, &log = logs[i], the_once, th_once]() {
+	int last_the {0};
+	while (!done.load()) {
+	  auto snapshot = table.getSnapshot();
+	  if (!snapshot)
+	    continue;
+	  const Node* the {snapshot->find("the")};
+	  int the_count {the ? the->getFrequency() : 0};
+	  long th_count {0};
+	  snapshot->findAll("th", [&th_count](const Node& node) {
+	      th_count += node.getFrequency();
+	    });
+	  if (the_count < last_the)
+	    ++log.went_backwards;
+	  if (the_count % the_once != 0 ||
+	      th_count != th_once * (the_count / the_once))
+	    ++log.torn;
+	  last_the = the_count;
+	}
+      });
+  }
+
+  std::shared_ptr<const typename Table::Snapshot> first;
+  for (int pass = 0; pass < kPasses; ++pass) {
+    table.processWordsFromFile(INPUT);
+    table.publishSnapshot();
+    if (!first)
+      first = table.getSnapshot();
+  }
+  done.store(true);
+  for (std::thread& reader : readers)
+    reader.join();
+
+  for (const ReaderLog& log : logs) {
+    CHECK(log.went_backwards == 0);
+    CHECK(log.torn == 0);
+  }
+  //a snapshot that is still held is not touched by later passes
+  CHECK(first->find("the")->getFrequency() == the_once);
+  CHECK(table.getSnapshot()->find("the")->getFrequency() ==
+	kPasses * the_once);
+}
+
+}  // namespace
+
+int main() {
+  testReadersSeeWholePasses<HashedSplays>(HashedSplays::Bucketing::kFirstLetter);
+  testReadersSeeWholePasses<HashedSplays>(HashedSplays::Bucketing::kHashed);
+  return checkResult();
+}
@@ -0,0 +1,164 @@
+#include <algorithm>     // for sort
+#include <cstddef>       // for size_t
+#include <map>           // for map
+#include <random>        // for mt19937, uniform_int_distribution
+#include <string>        // for string
+#include <string_view>   // for string_view
+#include <utility>       // for pair
+#include <vector>        // for vector
+
+#include "check.h"
+#include "node.h"
+#include "splay_tree.h"
+#include "string_pool.h"
+#include "vertex_pool.h"
+
+namespace {
+
+using Counts = std::map<std::string, int>;
+
+const int kTrees = 4;
+
+//short words over a small alphabet, so they share prefixes and a split
+//often lands on a word that is in the tree
+std::vector<std::string> makeVocabulary(std::mt19937& random) {
+  std::uniform_int_distribution<int> pick_length(1, 4);
+  std::uniform_int_distribution<int> pick_letter(0, 2);
+  std::vector<std::string> words;
+  for (int i = 0; i < 200; ++i) {
+    std::string word;
+    for (int length = pick_length(random); length > 0; --length)
+      word += static_cast<char>('a' + pick_letter(random));
+    words.push_back(word);
+  }
+  return words;
+}
+
+template <typename Tree>
+Counts contentsOf(const Tree& tree) {
+  Counts contents;
+  tree.visitInOrder([&contents](const Node& node) {
+      contents[std::string(node.getWord())] = node.getFrequency();
+    });
+  return contents;
+}
+
+//the k most frequent words starting with prefix, ranked like findTop
+std::vector<std::pair<std::string, int>> bruteTop(const Counts& counts,
+						  const std::string& prefix,
+						  int k) {
+  std::vector<std::pair<std::string, int>> matches;
+  for (const auto& [word, frequency] : counts)
+    if (word.compare(0, prefix.size(), prefix) == 0)
+      matches.emplace_back(word, frequency);
+  std::sort(matches.begin(), matches.end(),
+	    [](const auto& a, const auto& b) {
+	      if (a.second != b.second)
+		return a.second > b.second;
+	      return a.first < b.first;
+	    });
+  if (static_cast<int>(matches.size()) > k)
+    matches.resize(k);
+  return matches;
+}
+
+template <typename Tree>
+void checkTree(const Tree& tree, const Counts& counts,
+	       const std::vector<std::string>& words, std::mt19937& random) {
+  CHECK(contentsOf(tree) == counts);
+  CHECK(tree.getNodeCount() == static_cast<int>(counts.size()));
+  CHECK(tree.isEmpty() == counts.empty());
+  std::uniform_int_distribution<std::size_t> pick_word(0, words.size() - 1);
+  const std::string& word {words[pick_word(random)]};
+  const Node* found {tree.lookup(std::string_view(word))};
+  auto counted = counts.find(word);
+  CHECK((found != nullptr) == (counted != counts.end()));
+  if (found && counted != counts.end())
+    CHECK(found->getFrequency() == counted->second);
+  //findTop leans on the highest frequency kept in each subtree, which
+  //every operation below has to keep up to date
+  std::string prefix {word.substr(0, word.size() / 2)};
+  std::vector<std::pair<std::string, int>> top;
+  tree.findTop(std::string_view(prefix), 5, [&top](const Node& node) {
+      top.emplace_back(std::string(node.getWord()), node.getFrequency());
+    });
+  CHECK(top == bruteTop(counts, prefix, 5));
+}
+
+//random upserts, removes, splits, joins and unions on a few trees, each
+//checked against a std::map holding what the tree should hold
+template <template <typename> class VertexPool>
+void testAgainstMap(unsigned seed) {
+  using Tree = SplayTree<Node, VertexPool>;
+  std::mt19937 random(seed);
+  std::vector<std::string> words {makeVocabulary(random)};
+  StringPool pool;  // the words the trees hold, which must outlive them
+  std::vector<Tree> trees(kTrees);
+  std::vector<Counts> counts(kTrees);
+  std::uniform_int_distribution<int> pick_operation(0, 9);
+  std::uniform_int_distribution<int> pick_tree(0, kTrees - 1);
+  std::uniform_int_distribution<std::size_t> pick_word(0, words.size() - 1);
+  std::uniform_int_distribution<int> pick_frequency(1, 5);
+  for (int step = 0; step < 4000; ++step) {
+    int first {pick_tree(random)};
+    int second {(first + 1 + pick_tree(random) % (kTrees - 1)) % kTrees};
+    Tree& tree {trees[first]};
+    Counts& tree_counts {counts[first]};
+    const std::string& word {words[pick_word(random)]};
+    switch (pick_operation(random)) {
+      case 0:
+      case 1:
+      case 2:
+	tree.upsert(PendingWord{word, &pool});
+	++tree_counts[word];
+	break;
+      case 3: {
+	int frequency {pick_frequency(random)};
+	tree.accumulate(Node(pool, word, frequency));
+	tree_counts[word] += frequency;
+	break;
+      }
+      case 4:
+	if (tree_counts.erase(word))
+	  tree.remove(Node(pool, word, 0));
+	break;
+      case 5:
+      case 6: {
+	tree.split(Node(pool, word, 0), trees[second]);
+	auto cut = tree_counts.lower_bound(word);
+	counts[second] = Counts(cut, tree_counts.end());
+	tree_counts.erase(cut, tree_counts.end());
+	checkTree(trees[second], counts[second], words, random);
+	break;
+      }
+      case 7: {
+	//only trees that are already in order can be joined
+	Counts& greater {counts[second]};
+	if (!tree_counts.empty() && !greater.empty() &&
+	    tree_counts.rbegin()->first >= greater.begin()->first)
+	  break;
+	tree.join(trees[second]);
+	tree_counts.insert(greater.begin(), greater.end());
+	greater.clear();
+	checkTree(trees[second], greater, words, random);
+	break;
+      }
+      default:
+	tree.unite(trees[second]);
+	for (const auto& [other_word, frequency] : counts[second])
+	  tree_counts[other_word] += frequency;
+	checkTree(trees[second], counts[second], words, random);
+    }
+    checkTree(tree, tree_counts, words, random);
+  }
+}
+
+}  // namespace
+
+int main() {
+  for (unsigned seed = 1; seed <= 3; ++seed) {
+    testAgainstMap<SlabPool>(seed);
+    testAgainstMap<HeapPool>(seed);
+  }
+  return checkResult();
+}
@@ -0,0 +1,81 @@
+#include <algorithm>     // for sort
+#include <map>           // for map
+#include <random>        // for mt19937, uniform_int_distribution
+#include <string>        // for string
+#include <vector>        // for vector
+
+#include "check.h"
+#include "string_pool.h"
+#include "top_k.h"
+
+namespace {
+
+//more frequent first, alphabetical among equal frequencies, like getTop
+bool moreFrequent(const Node& a, const Node& b) {
+  if (a.getFrequency() != b.getFrequency())
+    return a.getFrequency() > b.getFrequency();
+  return a < b;
+}
+
+//the first k words of every word counted so far, ranked like getTop
+std::vector<Node> bruteTop(const std::map<std::string, int>& counts, int k,
+			   StringPool& pool) {
+  std::vector<Node> all;
+  for (const auto& [word, frequency] : counts)
+    all.emplace_back(pool, word, frequency);
+  std::sort(all.begin(), all.end(), moreFrequent);
+  if (static_cast<int>(all.size()) > k)
+    all.erase(all.begin() + k, all.end());
+  return all;
+}
+
+bool sameWords(const std::vector<Node>& a, const std::vector<Node>& b) {
+  if (a.size() != b.size())
+    return false;
+  for (std::size_t i = 0; i < a.size(); ++i)
+    if (a[i].getWord() != b[i].getWord() ||
+	a[i].getFrequency() != b[i].getFrequency())
+      return false;
+  return true;
+}
+
+//a word that ties the last leader and sorts before it must replace it
+void testTieReplacesLaterWord() {
+  StringPool pool;
+  TopK top(2);
+  std::map<std::string, int> counts;
+  for (const char* word : {"c", "c", "d", "d", "b", "b"})
+    top.update(Node(pool, word, ++counts[word]));
+  CHECK(sameWords(top.getTop(2), bruteTop(counts, 2, pool)));
+}
+
+//many small frequencies, so ties decide most of the leaders
+void testRandomCounts() {
+  std::mt19937 random(12);
+  std::vector<std::string> vocabulary;
+  for (char first = 'a'; first <= 'z'; ++first)
+    for (char second = 'a'; second <= 'e'; ++second)
+      vocabulary.push_back(std::string{first, second});
+  std::uniform_int_distribution<std::size_t> pick(0, vocabulary.size() - 1);
+  for (int capacity : {1, 3, 10, 50}) {
+    StringPool pool;
+    TopK top(capacity);
+    std::map<std::string, int> counts;
+    for (int i = 0; i < 2000; ++i) {
+      const std::string& word {vocabulary[pick(random)]};
+      top.update(Node(pool, word, ++counts[word]));
+      if (i % 97 == 0)
+	CHECK(sameWords(top.getTop(capacity),
+			bruteTop(counts, capacity, pool)));
+    }
+    CHECK(sameWords(top.getTop(capacity), bruteTop(counts, capacity, pool)));
+  }
+}
+
+}  // namespace
+
+int main() {
+  testTieReplacesLaterWord();
+  testRandomCounts();
+  return checkResult();
+}
@@ -0,0 +1,100 @@
+#include <cstring>   // for memcpy, memset
+
+#include "tokenizer.h"
+
+Tokenizer::Tokenizer() : Tokenizer(nullptr, nullptr) {}
+
+Tokenizer::Tokenizer(const char* begin, const char* end)
+  : cursor_{begin},
+    end_{end},
+    block_{begin},
+    word_mask_{0},
+    space_mask_{0},
+    kernel_{ScanKernel::best()},
+    fold_case_{false},
+    scratch_{} {
+  loadBlock();
+}
+
+void Tokenizer::reset(const char* begin, const char* end) {
+  cursor_ = begin;
+  end_ = end;
+  loadBlock();
+}
+
+void Tokenizer::loadBlock() {
+  block_ = cursor_;
+  std::size_t left {static_cast<std::size_t>(end_ - cursor_)};
+  if (left >= ScanKernel::kBlockSize) {
+    kernel_.classifyBlock(block_, word_mask_, space_mask_);
+    return;
+  }
+  //the last block is copied out and padded with spaces, which also ends a
+  //word that runs up to the end of the buffer
+  char padded[ScanKernel::kBlockSize];
+  std::memset(padded, ' ', sizeof(padded));
+  if (left > 0)
+    std::memcpy(padded, cursor_, left);
+  kernel_.classifyBlock(padded, word_mask_, space_mask_);
+}
+
+void Tokenizer::skipRun(const std::uint64_t& mask) {
+  while (cursor_ != end_) {
+    std::size_t offset {static_cast<std::size_t>(cursor_ - block_)};
+    if (offset >= ScanKernel::kBlockSize) {
+      loadBlock();
+      offset = 0;
+    }
+    //the bits shifted in from the top are zero, so the run always stops at
+    //the end of the block at the latest
+    std::uint64_t unmarked {~(mask >> offset)};
+    std::size_t run {unmarked ? static_cast<std::size_t>(
+	__builtin_ctzll(unmarked)) : ScanKernel::kBlockSize};
+    //padding past the end of the buffer counts as whitespace
+    if (run >= static_cast<std::size_t>(end_ - cursor_)) {
+      cursor_ = end_;
+      return;
+    }
+    cursor_ += run;
+    if (offset + run < ScanKernel::kBlockSize)
+      return;
+  }
+}
+
+std::string_view Tokenizer::finishWord(std::string_view word) {
+  if (!fold_case_)
+    return word;
+  //words in scratch_ are folded in place
+  if (word.data() != scratch_.data())
+    scratch_.resize(word.size());
+  kernel_.foldCase(&scratch_[0], word.data(), word.size());
+  return scratch_;
+}
+
+bool Tokenizer::next(std::string_view& word) {
+  while (true) {
+    //skip whitespace in front of the word
+    skipRun(space_mask_);
+    if (cursor_ == end_)
+      return false;
+    const char* start {cursor_};
+
+    //fast path, the word is a plain run of word bytes
+    skipRun(word_mask_);
+    if (cursor_ == end_ || isSpace(*cursor_)) {
+      word = finishWord(std::string_view(start, cursor_ - start));
+      return true;
+    }
+
+    //slow path, a byte has to be removed, so compact the rest into scratch_
+    scratch_.assign(start, cursor_);
+    for (++cursor_; cursor_ != end_ && !isSpace(*cursor_); ++cursor_) {
+      if (isWordChar(*cursor_))
+	scratch_.push_back(*cursor_);
+    }
+    if (!scratch_.empty()) {
+      word = finishWord(scratch_);
+      return true;
+    }
+  }
+}
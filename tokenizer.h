@@ -0,0 +1,119 @@
+/** 
+ *
+ */
+#ifndef TOKENIZER_H_
+#define TOKENIZER_H_
+
+#include <cstdint>       // for uint64_t
+#include <string>        // for string
+#include <string_view>   // for string_view
+
+#include "scan_kernel.h"
+
+/** 
+ * Tokenizer splits a raw character buffer into the words that are counted by
+ *   HashedSplays. A word is a run of non-whitespace bytes with every byte 
+ *   that is not a letter or an underscore removed, and words that end up 
+ *   empty are skipped. Bytes are classified a block at a time by a 
+ *   ScanKernel, which marks word bytes and whitespace with one bit each, so 
+ *   that runs of them are skipped by counting bits. The tokenizer does not 
+ *   own the buffer it scans; words are returned as views into that buffer 
+ *   whenever possible, and only words that needed bytes removed, or that 
+ *   are folded to lowercase, are copied into an internal scratch string that
+ *   is reused from one word to the next. 
+ */
+class Tokenizer {
+ public:
+  /** 
+   * Tokenizer no-arg constructor. 
+   *   Sets up a tokenizer over an empty buffer, using the best ScanKernel 
+   *   the processor supports. 
+   */
+  Tokenizer();
+
+  /** 
+   * Tokenizer 2-arg constructor. 
+   *   Sets up a tokenizer over the bytes in [begin, end), using the best 
+   *   ScanKernel the processor supports. 
+   *   @param begin The first byte of the buffer to be scanned. 
+   *   @param end One past the last byte of the buffer to be scanned. 
+   */
+  Tokenizer(const char* begin, const char* end);
+
+  /** 
+   * Classifies bytes with kernel from the next block on. 
+   *   @param kernel The kernel to be used. 
+   */
+  void setKernel(const ScanKernel& kernel) {kernel_ = kernel;}
+
+  /** 
+   * Returns the kernel bytes are classified with. 
+   */
+  const ScanKernel& getKernel() const {return kernel_;}
+
+  /** 
+   * Sets whether words are folded to lowercase before they are returned. 
+   *   Off by default, so "The" and "the" are different words. 
+   *   @param fold_case True to return every word in lowercase. 
+   */
+  void setFoldCase(bool fold_case) {fold_case_ = fold_case;}
+
+  /** 
+   * Points the tokenizer at a new buffer, keeping the scratch storage. 
+   *   @param begin The first byte of the buffer to be scanned. 
+   *   @param end One past the last byte of the buffer to be scanned. 
+   */
+  void reset(const char* begin, const char* end);
+
+  /** 
+   * Stores the next word of the buffer in word and returns true, or returns
+   *   false if the buffer has no words left. The view is invalidated by the
+   *   next call to next() or reset(), and when the buffer itself goes away. 
+   *   @param word Set to the next word found in the buffer. 
+   */
+  bool next(std::string_view& word);
+
+  /** 
+   * Returns true if c is kept as part of a word. 
+   *   @param c The byte to be classified. 
+   */
+  static bool isWordChar(char c) {return ScanKernel::isWordChar(c);}
+
+  /** 
+   * Returns true if c separates words. 
+   *   @param c The byte to be classified. 
+   */
+  static bool isSpace(char c) {return ScanKernel::isSpace(c);}
+
+ private:
+  /** 
+   * Classifies the block of bytes starting at cursor_. Past the end of the 
+   *   buffer, bytes are treated as whitespace. 
+   */
+  void loadBlock();
+
+  /** 
+   * Moves cursor_ past the bytes marked in mask, which is word_mask_ or 
+   *   space_mask_, loading blocks as it goes. Stops at the first unmarked 
+   *   byte or the end of the buffer. 
+   *   @param mask The mask of the bytes to be skipped. 
+   */
+  void skipRun(const std::uint64_t& mask);
+
+  /** 
+   * Returns word, or a lowercase copy of it in scratch_ if words are folded. 
+   *   @param word A word found in the buffer or in scratch_. 
+   */
+  std::string_view finishWord(std::string_view word);
+
+  const char* cursor_;       // next byte to be scanned
+  const char* end_;          // one past the last byte of the buffer
+  const char* block_;        // first byte of the block that was classified
+  std::uint64_t word_mask_;  // word bytes of the block, one bit each
+  std::uint64_t space_mask_; // whitespace bytes of the block, one bit each
+  ScanKernel kernel_;        // classifies blocks and folds case
+  bool fold_case_;           // whether words are returned in lowercase
+  std::string scratch_;      // holds words that had bytes removed
+};
+
+#endif //TOKENIZER_H_
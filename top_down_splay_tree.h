@@ -0,0 +1,621 @@
+/** 
+ *
+ */
+#ifndef TOP_DOWN_SPLAY_TREE_H_
+#define TOP_DOWN_SPLAY_TREE_H_
+
+#include <cstddef>       // for size_t
+#include <iostream>      // for cout
+#include <type_traits>   // for is_trivially_destructible
+#include <utility>       // for forward, move, pair
+#include <vector>        // for vector
+
+#include "tree_stats.h"
+#include "vertex_pool.h"
+
+
+/** 
+ * TopDownSplayTree is a splay tree that splays top-down, kept for 
+ *   bench.cpp to compare with SplayTree. Instead of first finding a vertex
+ *   and then rotating it up by its parent pointers, the search splits the 
+ *   tree into a left tree of smaller and a right tree of larger elements on
+ *   its way down, and puts the three pieces back together when it stops. 
+ *   Search and splay take a single pass, and vertices need no parent 
+ *   pointer, which makes every vertex 8 bytes smaller. insert, remove and 
+ *   contains behave like those of SplayTree, except that contains also 
+ *   splays.
+ *   Its interface is only the counting and visiting part of SplayTree's: 
+ *   insert, upsert, accumulate, remove, contains, splay, findAll, 
+ *   visitInOrder and buildFromSorted. It has no lookup, findTop, split, 
+ *   join, unite, depth bound or splay strategy, so it is not a Bucket of 
+ *   BasicHashedSplays. 
+ *   Vertices are allocated through the VertexPool policy like SplayTree.
+ */
+template <typename T, template <typename> class VertexPool = SlabPool>
+class TopDownSplayTree {
+ public:
+  /** 
+   * TopDownSplayTree no-arg constructor.
+   *   Sets root to nullptr, and counter values to 0.
+   */
+  TopDownSplayTree();
+
+  /** 
+   * TopDownSplayTree copy constructor.
+   *   Initializes a new tree by making a deep copy of the contents of
+   *   the tree in other.
+   *   @param other The tree whose contents are to be copied.
+   */
+  TopDownSplayTree(const TopDownSplayTree& other);
+
+  /** 
+   * TopDownSplayTree destructor.
+   *   Frees all the memory used by the vertices in the tree.
+   */
+  ~TopDownSplayTree();
+
+  /** 
+   * Inserts the element into the splay tree, splaying on the way down so
+   *   that the new vertex becomes the root. Equal elements are kept, like 
+   *   SplayTree::insert.
+   *   @param element_in The object to be inserted into the splay tree.
+   */
+  void insert(const T& element_in) {insert(T(element_in));}
+
+  /** 
+   * Moves the element into the splay tree, otherwise like insert above.
+   *   @param element_in The object to be moved into the splay tree.
+   */
+  void insert(T&& element_in);
+
+  /** 
+   * Finds the element equal to key, or inserts T(key) if there is none, in
+   *   a single top-down pass that leaves it at the root. If the element was
+   *   already present, its frequency counter is incremented. Returns a
+   *   reference to the element, which stays valid until it is removed.
+   *   @param key The key to be counted.
+   */
+  template <typename K>
+  T& upsert(const K& key);
+
+  /** 
+   * Like upsert, but inserts a copy of element_in if it is not present and
+   *   otherwise adds its frequency to the element already in the tree.
+   *   @param element_in The element whose count is to be added.
+   */
+  T& accumulate(const T& element_in);
+
+  /** 
+   * Removes the element equal to element from the tree, if there is one.
+   *   @param element The object to be removed.
+   */
+  void remove(const T& element);
+
+  /** 
+   * Returns true if an element equal to element is in the tree. The
+   *   closest element is splayed to the root either way.
+   *   @param element The object to be searched for.
+   */
+  bool contains(const T& element) {return splayKey(element);}
+
+  /** 
+   * Returns true if the tree has no elements.
+   */
+  bool isEmpty() const {return node_count_ == 0;}
+
+  /** 
+   * Prints each element in the tree in sorted order to the std output
+   *   stream.
+   */
+  void printTree();
+
+  /** 
+   * Returns the number of splay steps performed.
+   */
+  int getSplayCount() const {return splay_counter_;}
+
+  /** 
+   * Returns the splay step, comparison and depth counts of the tree, which
+   *   are all 0 unless the program is built with WFC_STATS defined. Going
+   *   down one level by linking a vertex into the left or right tree counts
+   *   as a zig, and going down two levels with a rotation as a zig-zig; a
+   *   zig-zag is done as two zigs.
+   */
+  TreeStats getStats() const {
+#ifdef WFC_STATS
+    return stats_;
+#else
+    return TreeStats();
+#endif
+  }
+
+  /** 
+   * Increments the frequency counter of the element at the root.
+   */
+  void incrementValue() {(root_->element).incrementFrequency();}
+
+  /** 
+   * Returns the number of elements in the tree.
+   */
+  int getNodeCount() const {return node_count_;}
+
+  /** 
+   * Replaces the contents of this tree with a deep copy of other.
+   *   @param other The tree whose contents are to be copied.
+   */
+  const TopDownSplayTree& operator=(const TopDownSplayTree& other);
+
+  /** 
+   * Prints the element at the root of the tree, if there is one.
+   */
+  void printRoot() const;
+
+  /** 
+   * Calls visit, in sorted order and without splaying, on every element
+   *   that begins with prefix, like SplayTree::findAll.
+   *   @param prefix What every element visited must start with.
+   *   @param visit A function object taking a const T&.
+   */
+  template <typename K, typename Visitor>
+  void findAll(const K& prefix, Visitor visit) const;
+
+  /** 
+   * Calls visit on every element in sorted order, without splaying.
+   *   @param visit A function object taking a const T&.
+   */
+  template <typename Visitor>
+  void visitInOrder(Visitor visit) const {visitInOrder(visit, root_);}
+
+  /** 
+   * Replaces the contents of the tree with count elements, where element i
+   *   is make(i), produced in sorted order, as a perfectly balanced tree.
+   *   @param count The number of elements in the new tree.
+   *   @param make A function object taking a std::size_t and returning a T.
+   */
+  template <typename Make>
+  void buildFromSorted(std::size_t count, Make make);
+
+  /** 
+   * Splays the element equal to element_in to the root. If there is none,
+   *   the last element on the search path becomes the root instead.
+   *   @param element_in The object to be splayed.
+   */
+  void splay(const T& element_in) {splayKey(element_in);}
+
+ private:
+  /** 
+   * Vertex is the storage container for objects in the tree. It only holds
+   *   the location of its children.
+   */
+  struct Vertex {
+    T element;
+    Vertex* left_child;
+    Vertex* right_child;
+
+    /** 
+     * Vertex 3 arg constructor.
+     *   @param in_element Copied or moved, depending on how it is passed,
+     *     to the member variable element.
+     *   @param left_vertex Contains the location of the vertex's left child.
+     *   @param right_vertex Contains the location of the vertex's right child.
+     */
+    template <typename U>
+    Vertex(U&& in_element, Vertex* left_vertex, Vertex* right_vertex)
+      : element(std::forward<U>(in_element)), left_child{left_vertex},
+	right_child{right_vertex} {}
+  };
+
+  /** 
+   * Splays the tree top-down around key: the vertex equal to key, or else
+   *   the last vertex on its search path, becomes the root. Returns true if
+   *   the root is equal to key afterwards.
+   *   @param key The object to be searched for in the tree.
+   */
+  template <typename K>
+  bool splayKey(const K& key);
+
+  /** 
+   * Makes new_vertex the root, splitting the old root and its subtree on
+   *   the side of key between it and new_vertex. The tree must have been
+   *   splayed around key and the root must not be equal to it, unless
+   *   equal elements are wanted after the old root.
+   *   @param new_vertex A vertex with no children holding key.
+   *   @param key The key new_vertex holds.
+   */
+  template <typename K>
+  void attachRoot(Vertex* new_vertex, const K& key);
+
+  /** 
+   * Finds the element equal to key, or inserts a vertex holding T(key) as
+   *   the new root if there is none, and returns the root.
+   *   @param key The object to be searched for in the tree.
+   *   @param found Set to true if the element was already in the tree.
+   */
+  template <typename K>
+  Vertex* findOrInsert(const K& key, bool& found);
+
+  /** 
+   * Deletes the vertex specified by the parameter as well as any
+   *   descendants of the vertex.
+   *   @param node The vertex that is to be deleted along with its descendants.
+   */
+  void clear(Vertex* node);
+
+  /** 
+   * Deletes every vertex in the tree and gives the memory back to the pool
+   *   in bulk, like SplayTree::clearAll.
+   */
+  void clearAll();
+
+  /** 
+   * Makes a new vertex for old and for each of its descendants, and returns
+   *   the copy of old.
+   *   @param old The vertex whose subtree is to be copied.
+   */
+  Vertex* copy(const Vertex* old);
+
+  /** 
+   * Calls visit on the element of node and of each of node's descendants
+   *   in order.
+   *   @param visit A function object taking a const T&.
+   *   @param node The vertex whose subtree is to be visited.
+   */
+  template <typename Visitor>
+  void visitInOrder(Visitor& visit, const Vertex* node) const;
+
+  /** 
+   * Builds a perfectly balanced subtree out of the elements make(first) up
+   *   to make(last - 1) and returns its root.
+   *   @param make A function object taking a std::size_t and returning a T.
+   *   @param first The index of the smallest element of the subtree.
+   *   @param last One past the index of the largest element of the subtree.
+   */
+  template <typename Make>
+  Vertex* buildRange(Make& make, std::size_t first, std::size_t last);
+
+  VertexPool<Vertex> pool_;  // allocates and frees the vertices
+  Vertex* root_;      // holds the root vertex for the tree
+  int splay_counter_; // counter for the number of splay steps performed
+  int node_count_;    // holds the number of vertices in the tree
+#ifdef WFC_STATS
+  TreeStats stats_;   // splay steps, comparisons and depths, when enabled
+#endif
+};
+
+
+// Function definitions below
+
+template <typename T, template <typename> class VertexPool>
+TopDownSplayTree<T, VertexPool>::TopDownSplayTree()
+  : pool_{}, root_{nullptr}, splay_counter_{0}, node_count_{0} {}
+
+template <typename T, template <typename> class VertexPool>
+TopDownSplayTree<T, VertexPool>::TopDownSplayTree(
+    const TopDownSplayTree& other) : TopDownSplayTree() {
+  *this = other;
+}
+
+template <typename T, template <typename> class VertexPool>
+TopDownSplayTree<T, VertexPool>::~TopDownSplayTree() {
+  clearAll();
+}
+
+template <typename T, template <typename> class VertexPool>
+template <typename K>
+bool TopDownSplayTree<T, VertexPool>::splayKey(const K& key) {
+  Vertex* node {root_};
+  if (!node)
+    return false;
+
+  //vertices known to be smaller than key are hung off the rightmost slot
+  //of the left tree, larger ones off the leftmost slot of the right tree
+  Vertex* left_tree {nullptr};
+  Vertex* right_tree {nullptr};
+  Vertex** left_slot {&left_tree};
+  Vertex** right_slot {&right_tree};
+  bool found {false};
+  WFC_STAT(int depth {0});
+  WFC_STAT(long comparisons {0});
+
+  while (true) {
+    WFC_STAT(++comparisons);
+    if (key < node->element) {
+      if (!node->left_child)
+	break;
+      //zig-zig, rotate the left child up before linking it
+      WFC_STAT(++comparisons);
+      if (key < node->left_child->element) {
+	Vertex* child {node->left_child};
+	node->left_child = child->right_child;
+	child->right_child = node;
+	node = child;
+	WFC_STAT(++stats_.zig_zig_count);
+	WFC_STAT(++depth);
+	if (!node->left_child)
+	  break;
+      }
+      else {
+	WFC_STAT(++stats_.zig_count);
+      }
+      //node and everything to its right is larger than key
+      *right_slot = node;
+      right_slot = &node->left_child;
+      node = node->left_child;
+    }
+    else if (node->element < key) {
+      WFC_STAT(++comparisons);
+      if (!node->right_child)
+	break;
+      //zig-zig, rotate the right child up before linking it
+      WFC_STAT(++comparisons);
+      if (node->right_child->element < key) {
+	Vertex* child {node->right_child};
+	node->right_child = child->left_child;
+	child->left_child = node;
+	node = child;
+	WFC_STAT(++stats_.zig_zig_count);
+	WFC_STAT(++depth);
+	if (!node->right_child)
+	  break;
+      }
+      else {
+	WFC_STAT(++stats_.zig_count);
+      }
+      //node and everything to its left is smaller than key
+      *left_slot = node;
+      left_slot = &node->right_child;
+      node = node->right_child;
+    }
+    //neither is less than the other, so node holds key
+    else {
+      WFC_STAT(++comparisons);
+      found = true;
+      break;
+    }
+    WFC_STAT(++depth);
+    ++splay_counter_;
+  }
+
+  //node's children go to the ends of the side trees, which become its own
+  *left_slot = node->left_child;
+  *right_slot = node->right_child;
+  node->left_child = left_tree;
+  node->right_child = right_tree;
+  root_ = node;
+  WFC_STAT(stats_.recordAccess(depth, comparisons));
+  return found;
+}
+
+template <typename T, template <typename> class VertexPool>
+template <typename K>
+void TopDownSplayTree<T, VertexPool>::attachRoot(Vertex* new_vertex,
+						 const K& key) {
+  if (root_) {
+    //the old root is the closest element to key, so only its subtree on
+    //the side of key lies between the two
+    if (key < root_->element) {
+      new_vertex->left_child = root_->left_child;
+      new_vertex->right_child = root_;
+      root_->left_child = nullptr;
+    }
+    else {
+      new_vertex->right_child = root_->right_child;
+      new_vertex->left_child = root_;
+      root_->right_child = nullptr;
+    }
+  }
+  root_ = new_vertex;
+  ++node_count_;
+}
+
+template <typename T, template <typename> class VertexPool>
+void TopDownSplayTree<T, VertexPool>::insert(T&& element_in) {
+  splayKey(element_in);
+  Vertex* new_vertex {pool_.create(std::move(element_in), nullptr, nullptr)};
+  attachRoot(new_vertex, new_vertex->element);
+}
+
+template <typename T, template <typename> class VertexPool>
+template <typename K>
+typename TopDownSplayTree<T, VertexPool>::Vertex*
+TopDownSplayTree<T, VertexPool>::findOrInsert(const K& key, bool& found) {
+  found = splayKey(key);
+  if (!found)
+    attachRoot(pool_.create(key, nullptr, nullptr), key);
+  return root_;
+}
+
+template <typename T, template <typename> class VertexPool>
+template <typename K>
+T& TopDownSplayTree<T, VertexPool>::upsert(const K& key) {
+  bool found;
+  Vertex* key_vertex {findOrInsert(key, found)};
+  //element already in tree, bump its counter
+  if (found)
+    (key_vertex->element).incrementFrequency();
+  return key_vertex->element;
+}
+
+template <typename T, template <typename> class VertexPool>
+T& TopDownSplayTree<T, VertexPool>::accumulate(const T& element_in) {
+  bool found;
+  Vertex* key_vertex {findOrInsert(element_in, found)};
+  //element already in tree, add the other count to it
+  if (found)
+    (key_vertex->element).addFrequency(element_in.getFrequency());
+  return key_vertex->element;
+}
+
+template <typename T, template <typename> class VertexPool>
+void TopDownSplayTree<T, VertexPool>::remove(const T& element) {
+  if (!splayKey(element))
+    return;
+
+  Vertex* old_root {root_};
+  //every element of the left subtree is smaller than element, so splaying
+  //it around element brings up its largest, which has no right child
+  if (!old_root->left_child)
+    root_ = old_root->right_child;
+  else {
+    root_ = old_root->left_child;
+    splayKey(element);
+    root_->right_child = old_root->right_child;
+  }
+  pool_.destroy(old_root);
+  --node_count_;
+}
+
+template <typename T, template <typename> class VertexPool>
+void TopDownSplayTree<T, VertexPool>::printTree() {
+  visitInOrder([](const T& element) {std::cout << element << "\n";});
+}
+
+template <typename T, template <typename> class VertexPool>
+void TopDownSplayTree<T, VertexPool>::printRoot() const {
+  if (root_)
+    std::cout << root_->element;
+}
+
+template <typename T, template <typename> class VertexPool>
+template <typename K, typename Visitor>
+void TopDownSplayTree<T, VertexPool>::findAll(const K& prefix,
+					      Visitor visit) const {
+  //holds the vertices still to be visited, smallest on top
+  std::vector<const Vertex*> pending;
+
+  //seek to the lower bound of prefix, keeping each vertex we pass on the
+  //left since those are the ones that come after it in order
+  const Vertex* node {root_};
+  while (node) {
+    if (node->element < prefix)
+      node = node->right_child;
+    else {
+      pending.push_back(node);
+      node = node->left_child;
+    }
+  }
+
+  //walk in order until an element no longer starts with prefix
+  while (!pending.empty()) {
+    node = pending.back();
+    pending.pop_back();
+    if (!(node->element).hasPrefix(prefix))
+      return;
+    visit(node->element);
+    for (node = node->right_child; node; node = node->left_child)
+      pending.push_back(node);
+  }
+}
+
+template <typename T, template <typename> class VertexPool>
+template <typename Visitor>
+void TopDownSplayTree<T, VertexPool>::visitInOrder(Visitor& visit,
+						   const Vertex* node) const {
+  //holds the vertices still to be visited, smallest on top, which are the
+  //ones we went left at, since there are no parent links to climb back up
+  std::vector<const Vertex*> pending;
+  for (; node; node = node->left_child)
+    pending.push_back(node);
+  while (!pending.empty()) {
+    node = pending.back();
+    pending.pop_back();
+    visit(node->element);
+    for (node = node->right_child; node; node = node->left_child)
+      pending.push_back(node);
+  }
+}
+
+template <typename T, template <typename> class VertexPool>
+void TopDownSplayTree<T, VertexPool>::clear(Vertex* node) {
+  //rotate left children up until node has none, then it can go and its 
+  //right child takes its place, so no stack is needed however deep it is
+  while (node) {
+    if (node->left_child) {
+      Vertex* left {node->left_child};
+      node->left_child = left->right_child;
+      left->right_child = node;
+      node = left;
+    }
+    else {
+      Vertex* right {node->right_child};
+      pool_.destroy(node);
+      node = right;
+    }
+  }
+}
+
+template <typename T, template <typename> class VertexPool>
+void TopDownSplayTree<T, VertexPool>::clearAll() {
+  //elements with nothing to clean up are dropped along with their slabs
+  if (!std::is_trivially_destructible<T>::value ||
+      !VertexPool<Vertex>::kBulkRelease)
+    clear(root_);
+  pool_.release();
+  root_ = nullptr;
+  node_count_ = 0;
+}
+
+template <typename T, template <typename> class VertexPool>
+typename TopDownSplayTree<T, VertexPool>::Vertex*
+TopDownSplayTree<T, VertexPool>::copy(const Vertex* old) {
+  Vertex* new_root {nullptr};
+  if (!old)
+    return new_root;
+  //each vertex still to be copied, along with the link its copy goes in
+  std::vector<std::pair<const Vertex*, Vertex**>> pending;
+  pending.emplace_back(old, &new_root);
+  while (!pending.empty()) {
+    const Vertex* from {pending.back().first};
+    Vertex** link {pending.back().second};
+    pending.pop_back();
+    *link = pool_.create(from->element, nullptr, nullptr);
+    if (from->right_child)
+      pending.emplace_back(from->right_child, &(*link)->right_child);
+    if (from->left_child)
+      pending.emplace_back(from->left_child, &(*link)->left_child);
+  }
+  return new_root;
+}
+
+template <typename T, template <typename> class VertexPool>
+const TopDownSplayTree<T, VertexPool>&
+TopDownSplayTree<T, VertexPool>::operator=(const TopDownSplayTree& other) {
+  if (this != &other) {
+    clearAll();
+    //every vertex of the copy comes out of a single slab
+    pool_.reserve(other.node_count_);
+    root_ = copy(other.root_);
+    node_count_ = other.node_count_;
+    splay_counter_ = other.splay_counter_;
+    WFC_STAT(stats_ = other.stats_);
+  }
+  return *this;
+}
+
+template <typename T, template <typename> class VertexPool>
+template <typename Make>
+void TopDownSplayTree<T, VertexPool>::buildFromSorted(std::size_t count,
+						      Make make) {
+  clearAll();
+  pool_.reserve(count);
+  root_ = buildRange(make, 0, count);
+  node_count_ = static_cast<int>(count);
+}
+
+//recursive function, depth is only log2 of the number of elements
+template <typename T, template <typename> class VertexPool>
+template <typename Make>
+typename TopDownSplayTree<T, VertexPool>::Vertex*
+TopDownSplayTree<T, VertexPool>::buildRange(Make& make, std::size_t first,
+					    std::size_t last) {
+  if (first == last)
+    return nullptr;
+  //build left to right so make is called with indexes in increasing order
+  std::size_t middle {first + (last - first) / 2};
+  Vertex* left {buildRange(make, first, middle)};
+  Vertex* new_vertex {pool_.create(make(middle), left, nullptr)};
+  new_vertex->right_child = buildRange(make, middle + 1, last);
+  return new_vertex;
+}
+
+#endif //  TOP_DOWN_SPLAY_TREE_H_
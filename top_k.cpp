@@ -0,0 +1,80 @@
+#include <algorithm>   // for max, min, partial_sort_copy
+#include <utility>     // for move, swap
+
+#include "top_k.h"
+
+TopK::TopK(int capacity)
+  : capacity_{static_cast<std::size_t>(std::max(0, capacity))},
+    heap_{},
+    position_{} {}
+
+std::vector<Node> TopK::getTop(int k) const {
+  std::vector<Node> top(std::min(heap_.size(),
+				 static_cast<std::size_t>(std::max(0, k))));
+  std::partial_sort_copy(heap_.begin(), heap_.end(), top.begin(), top.end(),
+			 moreFrequent);
+  return top;
+}
+
+void TopK::clear() {
+  heap_.clear();
+  position_.clear();
+}
+
+void TopK::updateLeader(const Node& counted) {
+  std::string_view word {counted.getWord()};
+  auto found = position_.find(word);
+  //already a leader, its frequency only went up so it sinks toward leaves
+  if (found != position_.end()) {
+    std::size_t index {found->second};
+    heap_[index].addFrequency(counted.getFrequency() -
+			      heap_[index].getFrequency());
+    siftDown(index);
+  }
+  //free spot, add it as a leaf
+  else if (heap_.size() < capacity_) {
+    position_.emplace(word, heap_.size());
+    heap_.push_back(counted);
+    siftUp(heap_.size() - 1);
+  }
+  //replaces the leader ranked last, reusing its entry in position_ so
+  //that a change of leaders doesn't allocate
+  else {
+    auto entry = position_.extract(heap_[0].getWord());
+    entry.key() = word;
+    entry.mapped() = 0;
+    position_.insert(std::move(entry));
+    heap_[0] = counted;
+    siftDown(0);
+  }
+}
+
+void TopK::siftUp(std::size_t index) {
+  while (index > 0) {
+    std::size_t parent {(index - 1) / 2};
+    if (!moreFrequent(heap_[parent], heap_[index]))
+      return;
+    swapLeaders(parent, index);
+    index = parent;
+  }
+}
+
+void TopK::siftDown(std::size_t index) {
+  while (true) {
+    std::size_t last {index};
+    for (std::size_t child : {2 * index + 1, 2 * index + 2}) {
+      if (child < heap_.size() && moreFrequent(heap_[last], heap_[child]))
+	last = child;
+    }
+    if (last == index)
+      return;
+    swapLeaders(last, index);
+    index = last;
+  }
+}
+
+void TopK::swapLeaders(std::size_t a, std::size_t b) {
+  std::swap(heap_[a], heap_[b]);
+  position_[heap_[a].getWord()] = a;
+  position_[heap_[b].getWord()] = b;
+}
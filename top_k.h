@@ -0,0 +1,114 @@
+/** 
+ *
+ */
+#ifndef TOP_K_H_
+#define TOP_K_H_
+
+#include <cstddef>        // for size_t
+#include <string_view>    // for string_view
+#include <unordered_map>  // for unordered_map
+#include <vector>         // for vector
+
+#include "node.h"
+
+/** 
+ * TopK keeps track of the capacity most frequent words while they are being
+ *   counted. It is told the new frequency of a word every time that word is 
+ *   counted, and keeps the leaders in a min-heap ordered like getTop, by 
+ *   frequency and then alphabetically, so the leader ranked last is always 
+ *   on top and can be replaced in O(log capacity) time. Since frequencies 
+ *   only grow, a word that is not a leader never ranks before the last 
+ *   leader, ties included, which keeps the leaders exact as long as every 
+ *   increase is reported. 
+ *   Leaders are copies of the nodes they were given, which refer to the 
+ *   same words, so those words must outlive the TopK, like the pooled words
+ *   of HashedSplays.
+ */
+class TopK {
+ public:
+  /** 
+   * TopK 1-arg constructor. 
+   *   Sets up an empty set of leaders. 
+   *   @param capacity The number of leaders to keep. Values below 0 are 
+   *     set to 0, which turns tracking off. 
+   */
+  explicit TopK(int capacity);
+  
+  /** 
+   * Records that the frequency of the word of counted has grown to the 
+   *   frequency of counted. 
+   *   @param counted The node of the word that was counted. 
+   */
+  void update(const Node& counted) {
+    //cheap early out for the common case of a word that can't be a leader
+    if (heap_.size() == capacity_ &&
+	(capacity_ == 0 || !moreFrequent(counted, heap_[0])))
+      return;
+    updateLeader(counted);
+  }
+  
+  /** 
+   * Returns the k most frequent leaders, most frequent first. Words with the
+   *   same frequency are in alphabetical order. 
+   *   @param k The number of leaders wanted, at most the capacity. 
+   */
+  std::vector<Node> getTop(int k) const;
+  
+  /** 
+   * Returns the number of leaders kept. 
+   */
+  int getCapacity() const {return static_cast<int>(capacity_);}
+  
+  /** 
+   * Forgets every leader. 
+   */
+  void clear();
+  
+ private:
+  /** 
+   * Returns true if a ranks before b in getTop: it is more frequent, or as
+   *   frequent and alphabetically first. 
+   *   @param a One word and its frequency. 
+   *   @param b The other word and its frequency. 
+   */
+  static bool moreFrequent(const Node& a, const Node& b) {
+    if (a.getFrequency() != b.getFrequency())
+      return a.getFrequency() > b.getFrequency();
+    return a < b;
+  }
+  
+  /** 
+   * Raises the frequency of the word of counted if it is a leader, 
+   *   otherwise makes a copy of counted a leader in place of the least 
+   *   frequent one, or in a free spot. 
+   *   @param counted The node of the word that was counted. 
+   */
+  void updateLeader(const Node& counted);
+  
+  /** 
+   * Moves the leader at index toward the top of the heap until its parent 
+   *   does not rank before it. 
+   *   @param index The position of the leader in heap_. 
+   */
+  void siftUp(std::size_t index);
+  
+  /** 
+   * Moves the leader at index away from the top of the heap until neither 
+   *   child ranks after it. 
+   *   @param index The position of the leader in heap_. 
+   */
+  void siftDown(std::size_t index);
+  
+  /** 
+   * Swaps two leaders in heap_ and records their new positions. 
+   *   @param a The position of one leader. 
+   *   @param b The position of the other leader. 
+   */
+  void swapLeaders(std::size_t a, std::size_t b);
+  
+  std::size_t capacity_;    // number of leaders to keep
+  std::vector<Node> heap_;  // leaders, the one ranked last at index 0
+  std::unordered_map<std::string_view, std::size_t> position_;  // word->index
+};
+
+#endif //TOP_K_H_
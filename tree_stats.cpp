@@ -0,0 +1,42 @@
+#include <algorithm>   // for max
+#include <sstream>     // for ostringstream
+
+#include "tree_stats.h"
+
+TreeStats& TreeStats::operator+=(const TreeStats& other) {
+  zig_count += other.zig_count;
+  zig_zig_count += other.zig_zig_count;
+  zig_zag_count += other.zig_zag_count;
+  comparison_count += other.comparison_count;
+  access_count += other.access_count;
+  depth_sum += other.depth_sum;
+  max_depth = std::max(max_depth, other.max_depth);
+  rebuild_count += other.rebuild_count;
+  rebuilt_vertices += other.rebuilt_vertices;
+  for (int i = 0; i < kDepthBuckets; ++i)
+    depth_histogram[i] += other.depth_histogram[i];
+  return *this;
+}
+
+std::string TreeStats::toJson() const {
+  std::ostringstream json;
+  json << "{\"zig\": " << zig_count
+       << ", \"zig_zig\": " << zig_zig_count
+       << ", \"zig_zag\": " << zig_zag_count
+       << ", \"rotations\": " << getRotationCount()
+       << ", \"comparisons\": " << comparison_count
+       << ", \"accesses\": " << access_count
+       << ", \"mean_depth\": "
+       << (access_count ? static_cast<double>(depth_sum) / access_count : 0.0)
+       << ", \"max_depth\": " << max_depth
+       << ", \"rebuilds\": " << rebuild_count
+       << ", \"rebuilt_vertices\": " << rebuilt_vertices
+       << ", \"depth_histogram_log2\": [";
+  int used {kDepthBuckets};
+  while (used > 0 && depth_histogram[used - 1] == 0)
+    --used;
+  for (int i = 0; i < used; ++i)
+    json << (i ? ", " : "") << depth_histogram[i];
+  json << "]}";
+  return json.str();
+}
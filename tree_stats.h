@@ -0,0 +1,91 @@
+/** 
+ *
+ */
+#ifndef TREE_STATS_H_
+#define TREE_STATS_H_
+
+#include <array>          // for array
+#include <chrono>         // for steady_clock
+#include <string>         // for string
+
+//WFC_STAT(statement) keeps statement only when the program is built with
+//WFC_STATS defined, so a normal build does no counting or timing at all
+#ifdef WFC_STATS
+#define WFC_STAT(statement) statement
+#else
+#define WFC_STAT(statement)
+#endif
+
+/** 
+ * TreeStats counts the work done inside a SplayTree: the rotations made by
+ *   splaying, split into zig, zig-zig and zig-zag steps, the key comparisons
+ *   made while searching, and how deep the searched for vertices were
+ *   before they were splayed, after any rebuild made to bound the depth,
+ *   along with the number and size of those rebuilds. Trees only collect
+ *   them when built with WFC_STATS defined; otherwise every count stays 0.
+ */
+struct TreeStats {
+  static const int kDepthBuckets = 32;
+
+  long zig_count = 0;          // single rotations of a child of the root
+  long zig_zig_count = 0;      // double rotations in the same direction
+  long zig_zag_count = 0;      // double rotations in opposite directions
+  long comparison_count = 0;   // calls to the key comparison operators
+  long access_count = 0;       // searches that found or inserted a vertex
+  long depth_sum = 0;          // depths of those vertices added up
+  int max_depth = 0;
+  long rebuild_count = 0;      // subtrees rebuilt to bound the depth
+  long rebuilt_vertices = 0;   // vertices in those subtrees added up
+  //accesses at depth 0 are counted in bucket 0, and those at a depth of at
+  //least 2^(i - 1) but below 2^i in bucket i
+  std::array<long, kDepthBuckets> depth_histogram {};
+
+  /** 
+   * Records a search that reached a vertex at depth after making
+   *   comparisons key comparisons.
+   *   @param depth The number of edges between the root and the vertex.
+   *   @param comparisons The number of comparisons made on the way down.
+   */
+  void recordAccess(int depth, long comparisons) {
+    int bucket {0};
+    while (bucket < kDepthBuckets - 1 && (depth >> bucket))
+      ++bucket;
+    ++depth_histogram[bucket];
+    ++access_count;
+    depth_sum += depth;
+    comparison_count += comparisons;
+    if (depth > max_depth)
+      max_depth = depth;
+  }
+
+  /** 
+   * Returns the number of single rotations performed, counting two for
+   *   every zig-zig and zig-zag step.
+   */
+  long getRotationCount() const {
+    return zig_count + 2 * (zig_zig_count + zig_zag_count);
+  }
+
+  /** 
+   * Adds the counts of other to these, keeping the larger maximum depth.
+   *   @param other The counts to be added.
+   */
+  TreeStats& operator+=(const TreeStats& other);
+
+  /** 
+   * Returns the counts as a JSON object. The depth histogram is cut off
+   *   after its last non-empty bucket.
+   */
+  std::string toJson() const;
+};
+
+/** 
+ * Returns the number of seconds gone by since start.
+ *   @param start The point in time to measure from.
+ */
+inline double elapsedSeconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+				       start).count();
+}
+
+#endif //  TREE_STATS_H_
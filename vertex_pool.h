@@ -0,0 +1,174 @@
+/** 
+ *
+ */
+#ifndef VERTEX_POOL_H_
+#define VERTEX_POOL_H_
+
+#include <algorithm> // for find
+#include <cstddef>   // for size_t
+#include <memory>    // for shared_ptr
+#include <new>       // for placement new
+#include <utility>   // for forward
+#include <vector>    // for vector
+
+/** 
+ * SlabPool is the default vertex allocation policy for SplayTree. Vertices 
+ *   are carved out of large contiguous slabs instead of being allocated one 
+ *   at a time, and the slots of destroyed vertices are kept on a free list 
+ *   to be handed out again. Every slab is released at once by release() or 
+ *   when the pool is destroyed. Slabs start small and double in size up to 
+ *   MAX_SLAB_SLOTS slots. Slabs can be shared between pools, so that the 
+ *   vertices of one tree can be handed over to another without being 
+ *   copied; a slab is freed once no pool holds it any more. 
+ */
+template <typename V>
+class SlabPool {
+ public:
+  // release() frees every vertex, so the tree may skip walking its vertices
+  static constexpr bool kBulkRelease = true;
+
+  /** 
+   * SlabPool no-arg constructor. 
+   *   Starts out with no slabs allocated. 
+   */
+  SlabPool() : free_list_{nullptr}, cursor_{nullptr}, slab_end_{nullptr},
+    next_slab_slots_{MIN_SLAB_SLOTS} {}
+
+  SlabPool(const SlabPool&) = delete;
+  SlabPool& operator=(const SlabPool&) = delete;
+
+  /** 
+   * Constructs a vertex from args in a free slot and returns it. 
+   *   @param args The arguments passed on to the constructor of V. 
+   */
+  template <typename... Args>
+  V* create(Args&&... args) {
+    Slot* slot {free_list_};
+    if (slot)
+      free_list_ = slot->next_free;
+    else {
+      if (cursor_ == slab_end_)
+	addSlab(next_slab_slots_);
+      slot = cursor_++;
+    }
+    return new (slot->storage) V(std::forward<Args>(args)...);
+  }
+
+  /** 
+   * Destroys vertex and puts its slot on the free list. 
+   *   @param vertex A vertex that was returned by create(). 
+   */
+  void destroy(V* vertex) {
+    vertex->~V();
+    Slot* slot {reinterpret_cast<Slot*>(vertex)};
+    slot->next_free = free_list_;
+    free_list_ = slot;
+  }
+
+  /** 
+   * Makes sure the next count vertices created come out of one slab, 
+   *   allocating a slab of exactly count slots if the current one is short. 
+   *   @param count The number of vertices about to be created. 
+   */
+  void reserve(std::size_t count) {
+    if (static_cast<std::size_t>(slab_end_ - cursor_) < count)
+      addSlab(count);
+  }
+
+  /** 
+   * Holds on to every slab of other as well, so that vertices created by 
+   *   other may be kept after other is released. Slots freed by other are 
+   *   not reused. 
+   *   @param other The pool whose vertices are being taken over. 
+   */
+  void share(const SlabPool& other) {
+    for (const std::shared_ptr<Slot[]>& slab : other.slabs_) {
+      if (std::find(slabs_.begin(), slabs_.end(), slab) == slabs_.end())
+	slabs_.push_back(slab);
+    }
+  }
+
+  /** 
+   * Lets go of every slab at once, which frees the ones no other pool 
+   *   shares. Destructors are not run, so any vertex whose element needs 
+   *   cleaning up must have been destroyed first. 
+   */
+  void release() {
+    slabs_.clear();
+    free_list_ = cursor_ = slab_end_ = nullptr;
+    next_slab_slots_ = MIN_SLAB_SLOTS;
+  }
+
+ private:
+  static const std::size_t MIN_SLAB_SLOTS = 64;
+  static const std::size_t MAX_SLAB_SLOTS = 65536;
+
+  /** 
+   * Slot is the raw storage for one vertex. While the slot is unused it 
+   *   holds the link to the next free slot instead. 
+   */
+  union Slot {
+    Slot* next_free;
+    alignas(V) unsigned char storage[sizeof(V)];
+  };
+
+  /** 
+   * Allocates a new slab of slots slots and makes it the current slab. 
+   *   @param slots The number of vertices the slab can hold. 
+   */
+  void addSlab(std::size_t slots) {
+    slabs_.emplace_back(new Slot[slots]);
+    cursor_ = slabs_.back().get();
+    slab_end_ = cursor_ + slots;
+    if (next_slab_slots_ < MAX_SLAB_SLOTS)
+      next_slab_slots_ *= 2;
+  }
+
+  std::vector<std::shared_ptr<Slot[]>> slabs_;  // every slab in use
+  Slot* free_list_;               // slots given back by destroy()
+  Slot* cursor_;                  // next never used slot in current slab
+  Slot* slab_end_;                // one past the last slot of current slab
+  std::size_t next_slab_slots_;   // size of the next slab to be allocated
+};
+
+/** 
+ * HeapPool is a vertex allocation policy that allocates every vertex 
+ *   separately with new and frees it with delete, which is what SplayTree 
+ *   did before it took a policy. Kept for comparison with SlabPool. 
+ */
+template <typename V>
+class HeapPool {
+ public:
+  // vertices must be destroyed one by one
+  static constexpr bool kBulkRelease = false;
+
+  /** 
+   * Allocates a vertex constructed from args and returns it. 
+   *   @param args The arguments passed on to the constructor of V. 
+   */
+  template <typename... Args>
+  V* create(Args&&... args) {return new V(std::forward<Args>(args)...);}
+
+  /** 
+   * Frees vertex. 
+   *   @param vertex A vertex that was returned by create(). 
+   */
+  void destroy(V* vertex) {delete vertex;}
+
+  /** 
+   * Does nothing, vertices are allocated one at a time. 
+   */
+  void reserve(std::size_t) {}
+
+  /** 
+   * Does nothing, vertices don't belong to the pool that allocated them. 
+   */
+  void share(const HeapPool&) {}
+
+  /** 
+   * Does nothing, every vertex has already been freed by destroy(). 
+   */
+  void release() {}
+};
+
+#endif //VERTEX_POOL_H_
@@ -0,0 +1,162 @@
+#include <fcntl.h>       // for open
+#include <unistd.h>      // for write, close
+
+#include <cerrno>        // for errno, EINTR
+#include <charconv>      // for to_chars
+#include <cstring>       // for memcpy
+
+#include "word_sink.h"
+
+WordSink::WordSink(Format format)
+  : format_{format},
+    buffer_(BUFFER_SIZE),
+    filled_{0},
+    file_descriptor_{-1},
+    owns_descriptor_{false},
+    failed_{false},
+    bytes_written_{0} {}
+
+WordSink::~WordSink() {close();}
+
+bool WordSink::open(const std::string& file_name) {
+  close();
+  int fd {::open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)};
+  if (fd < 0)
+    return false;
+  file_descriptor_ = fd;
+  owns_descriptor_ = true;
+  failed_ = false;
+  return true;
+}
+
+void WordSink::attach(int file_descriptor) {
+  close();
+  file_descriptor_ = file_descriptor;
+  owns_descriptor_ = false;
+  failed_ = false;
+}
+
+void WordSink::write(const Node& node) {
+  std::string_view word {node.getWord()};
+  switch (format_) {
+  case Format::kTsv:
+    append(word.data(), word.size());
+    append("\t", 1);
+    appendNumber(node.getFrequency());
+    append("\n", 1);
+    break;
+  case Format::kCsv:
+    appendCsvWord(word);
+    append(",", 1);
+    appendNumber(node.getFrequency());
+    append("\n", 1);
+    break;
+  case Format::kJsonLines:
+    append("{\"word\":\"", 9);
+    appendJsonWord(word);
+    append("\",\"frequency\":", 14);
+    appendNumber(node.getFrequency());
+    append("}\n", 2);
+    break;
+  case Format::kBinary: {
+    std::uint32_t header[2] {static_cast<std::uint32_t>(word.size()),
+			     static_cast<std::uint32_t>(node.getFrequency())};
+    append(reinterpret_cast<const char*>(header), sizeof(header));
+    append(word.data(), word.size());
+    break;
+  }
+  }
+}
+
+bool WordSink::flush() {
+  const char* data {buffer_.data()};
+  std::size_t left {filled_};
+  //write may take less than it is given, so keep going until it's all out
+  while (left > 0 && good()) {
+    ssize_t written {::write(file_descriptor_, data, left)};
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written <= 0) {
+      failed_ = true;
+      break;
+    }
+    data += written;
+    left -= written;
+    bytes_written_ += written;
+  }
+  filled_ = 0;
+  return good();
+}
+
+bool WordSink::close() {
+  if (file_descriptor_ < 0)
+    return !failed_;
+  flush();
+  if (owns_descriptor_ && ::close(file_descriptor_) != 0)
+    failed_ = true;
+  bool ok {!failed_};
+  file_descriptor_ = -1;
+  owns_descriptor_ = false;
+  return ok;
+}
+
+char* WordSink::reserve(std::size_t size) {
+  if (buffer_.size() - filled_ < size) {
+    flush();
+    if (buffer_.size() < size)
+      buffer_.resize(size);
+  }
+  return buffer_.data() + filled_;
+}
+
+void WordSink::append(const char* data, std::size_t size) {
+  std::memcpy(reserve(size), data, size);
+  filled_ += size;
+}
+
+void WordSink::appendNumber(int number) {
+  //an int has at most 11 characters with its sign
+  char* start {reserve(16)};
+  filled_ = std::to_chars(start, start + 16, number).ptr - buffer_.data();
+}
+
+void WordSink::appendCsvWord(std::string_view word) {
+  if (word.find_first_of(",\"\r\n") == std::string_view::npos) {
+    append(word.data(), word.size());
+    return;
+  }
+  //quotes inside a quoted word are doubled
+  char* out {reserve(2 * word.size() + 2)};
+  *out++ = '"';
+  for (char c : word) {
+    if (c == '"')
+      *out++ = '"';
+    *out++ = c;
+  }
+  *out++ = '"';
+  filled_ = out - buffer_.data();
+}
+
+void WordSink::appendJsonWord(std::string_view word) {
+  static const char kHexDigits[] = "0123456789abcdef";
+  //the longest escape, \u00XX, is 6 characters
+  char* out {reserve(6 * word.size())};
+  for (char c : word) {
+    unsigned char byte {static_cast<unsigned char>(c)};
+    if (c == '"' || c == '\\') {
+      *out++ = '\\';
+      *out++ = c;
+    }
+    else if (byte < 0x20) {
+      *out++ = '\\';
+      *out++ = 'u';
+      *out++ = '0';
+      *out++ = '0';
+      *out++ = kHexDigits[byte >> 4];
+      *out++ = kHexDigits[byte & 0xf];
+    }
+    else
+      *out++ = c;
+  }
+  filled_ = out - buffer_.data();
+}
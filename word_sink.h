@@ -0,0 +1,140 @@
+/** 
+ *
+ */
+#ifndef WORD_SINK_H_
+#define WORD_SINK_H_
+
+#include <cstddef>       // for size_t
+#include <cstdint>       // for uint64_t
+#include <string>        // for string
+#include <string_view>   // for string_view
+#include <vector>        // for vector
+
+#include "node.h"
+
+/** 
+ * WordSink writes counted words to a file or file descriptor in a format
+ *   that is cheap to parse, one record per word. Records are formatted
+ *   straight into a large buffer that is handed to write(2) whenever it
+ *   fills up, so dumping a table takes one system call per buffer instead
+ *   of a stream insertion per word. The formats are:
+ *     kTsv        word, a tab, the frequency and a newline.
+ *     kCsv        the same with a comma, words holding a comma, a quote or
+ *                 a line break are quoted as in RFC 4180.
+ *     kJsonLines  {"word":"...","frequency":n} and a newline per word.
+ *     kBinary     the length of the word and its frequency as 32 bit
+ *                 numbers in the byte order of the machine, then the
+ *                 characters of the word.
+ *   No header is written. Once a write fails the sink stops writing and
+ *   good() returns false.
+ */
+class WordSink {
+ public:
+  enum class Format {kTsv, kCsv, kJsonLines, kBinary};
+
+  /** 
+   * WordSink 1-arg constructor.
+   *   Sets up a sink with nowhere to write yet.
+   *   @param format How every word is written.
+   */
+  explicit WordSink(Format format);
+
+  /** 
+   * WordSink destructor.
+   *   Flushes the buffer, and closes the file if the sink opened it.
+   */
+  ~WordSink();
+
+  WordSink(const WordSink&) = delete;
+  WordSink& operator=(const WordSink&) = delete;
+
+  /** 
+   * Creates or truncates file_name and writes to it from now on. Returns
+   *   false if the file could not be opened.
+   *   @param file_name The name of the file to be written.
+   */
+  bool open(const std::string& file_name);
+
+  /** 
+   * Writes to file_descriptor from now on, which stays open when the sink
+   *   is closed.
+   *   @param file_descriptor A descriptor open for writing, like 1 for the
+   *     standard output.
+   */
+  void attach(int file_descriptor);
+
+  /** 
+   * Adds the word and frequency of node to the buffer, writing the buffer
+   *   out first if the record doesn't fit.
+   *   @param node The word to be written.
+   */
+  void write(const Node& node);
+
+  /** 
+   * Writes out whatever is in the buffer. Returns good().
+   */
+  bool flush();
+
+  /** 
+   * Flushes the buffer and lets go of the file, closing it if the sink
+   *   opened it. Returns good().
+   */
+  bool close();
+
+  /** 
+   * Returns false once a write has failed, or if there is nowhere to write.
+   */
+  bool good() const {return !failed_ && file_descriptor_ >= 0;}
+
+  /** 
+   * Returns the number of bytes handed to the file so far, not counting
+   *   what is still in the buffer.
+   */
+  std::uint64_t getBytesWritten() const {return bytes_written_;}
+
+ private:
+  static const std::size_t BUFFER_SIZE = 1 << 20;
+
+  /** 
+   * Makes sure size more bytes fit in the buffer, flushing it, or growing
+   *   it for a record longer than the whole buffer. Returns where they go.
+   *   @param size The number of bytes about to be added.
+   */
+  char* reserve(std::size_t size);
+
+  /** 
+   * Appends word to the buffer, quoted for CSV if it needs to be.
+   *   @param word The word to be appended.
+   */
+  void appendCsvWord(std::string_view word);
+
+  /** 
+   * Appends word to the buffer with the characters JSON strings can't
+   *   hold as they are escaped.
+   *   @param word The word to be appended.
+   */
+  void appendJsonWord(std::string_view word);
+
+  /** 
+   * Appends the decimal digits of number to the buffer.
+   *   @param number The number to be appended.
+   */
+  void appendNumber(int number);
+
+  /** 
+   * Appends size bytes at data to the buffer.
+   *   @param data The bytes to be appended.
+   *   @param size The number of bytes.
+   */
+  void append(const char* data, std::size_t size);
+
+  Format format_;               // how every word is written
+  std::vector<char> buffer_;    // records not written out yet
+  std::size_t filled_;          // bytes of buffer_ in use
+  int file_descriptor_;         // where records go, -1 if nowhere
+  bool owns_descriptor_;        // whether close() closes file_descriptor_
+  bool failed_;                 // whether a write has failed
+  std::uint64_t bytes_written_; // bytes handed to the file so far
+};
+
+#endif //WORD_SINK_H_